@@ -16,7 +16,7 @@
 #include "os3/base/Calculation.h"
 
 #include <cmath>
-#include <fstream>
+#include <limits>
 
 #include "os3/base/WebServiceControl.h"
 #include "os3/base/WeatherControl.h"
@@ -26,9 +26,24 @@
 
 Define_Module(Calculation);
 
-const double Calculation::C = 299792458;                    // In m/s;
-const double Calculation::Boltzmann = -228.6;               // In dBWs/K
-const double Calculation::EarthRadius = 6378.137764899274;  // In km
+bool linkMemoKey::operator<(const linkMemoKey& other) const
+{
+    if (satIndex != other.satIndex)                 return satIndex < other.satIndex;
+    if (satLatitude != other.satLatitude)           return satLatitude < other.satLatitude;
+    if (satLongitude != other.satLongitude)         return satLongitude < other.satLongitude;
+    if (satAltitude != other.satAltitude)           return satAltitude < other.satAltitude;
+    if (latitude != other.latitude)                 return latitude < other.latitude;
+    if (longitude != other.longitude)               return longitude < other.longitude;
+    if (altitude != other.altitude)                 return altitude < other.altitude;
+    if (lambda != other.lambda)                     return lambda < other.lambda;
+    if (transmitterGain != other.transmitterGain)   return transmitterGain < other.transmitterGain;
+    if (receiverGain != other.receiverGain)         return receiverGain < other.receiverGain;
+    if (transmitterPower != other.transmitterPower) return transmitterPower < other.transmitterPower;
+    if (bandwidth != other.bandwidth)               return bandwidth < other.bandwidth;
+    if (dG != other.dG)                             return dG < other.dG;
+    if (tR != other.tR)                             return tR < other.tR;
+    return dR < other.dR;
+}
 
 void Calculation::initialize()
 {
@@ -49,75 +64,85 @@ void Calculation::initialize()
 
     // Fill map with coefficients for specific rain attenuation
     fillRainMap();
+
+    // Memo tables for repeated link budget requests within one simulation event
+    memoEnabled = par("memoizeLinkBudget");
+    memoResolution = par("memoLocationResolution");
+    if (memoResolution <= 0) {
+        error("Error in Calculation::initialize(): memoLocationResolution must be positive.");
+    }
+    memoTime = simTime();
+    geometryMemoHits = 0;
+    geometryMemoMisses = 0;
+    fslMemoHits = 0;
+    fslMemoMisses = 0;
+    snrMemoHits = 0;
+    snrMemoMisses = 0;
+    WATCH(geometryMemoHits);
+    WATCH(geometryMemoMisses);
+    WATCH(fslMemoHits);
+    WATCH(fslMemoMisses);
+    WATCH(snrMemoHits);
+    WATCH(snrMemoMisses);
+
+    interferersEvaluated = 0;
+    interferersPruned = 0;
+    groundStationsCollected = false;
 }
 
-void Calculation::fillRainMap()
+void Calculation::finish()
 {
-    // source: 'The aR^b Relation in the Calculation of Rain Attenuation', Olsen and Rogers and Hodge
-    std::string fileName = par("rainTableFile");
-    std::fstream fileStream;
-
-    fileStream.open(fileName.c_str(), std::ios::in);
+    // Each memo is counted separately, as a miss of the SNR memo looks up the geometry memo
+    recordScalar("geometryMemoHits", geometryMemoHits);
+    recordScalar("geometryMemoMisses", geometryMemoMisses);
+    recordScalar("fslMemoHits", fslMemoHits);
+    recordScalar("fslMemoMisses", fslMemoMisses);
+    recordScalar("snrMemoHits", snrMemoHits);
+    recordScalar("snrMemoMisses", snrMemoMisses);
+    recordScalar("interferersEvaluated", interferersEvaluated);
+    recordScalar("interferersPruned", interferersPruned);
+}
 
-    if (!fileStream.good()) {
-        error("Error in Calculation::fillRainMap: File not found!");
+void Calculation::validateMemo()
+{
+    if (simTime() != memoTime) {
+        geometryMemo.clear();
+        fslMemo.clear();
+        snrMemo.clear();
+        memoTime = simTime();
     }
+}
 
-    // Extract data from CSV file
-    while (fileStream.good()) {
-        char tmpLine[100];
-        fileStream.getline(tmpLine, 100);
-        std::string tmpString = tmpLine;
-
-        // Ignore lines beginning with "#"
-        if (tmpString.find("#") == std::string::npos) {
-            // Search for new values and parse them into rainCoeffMap
-            rainCoefficients newCoeff;
-            const double newFreq = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.aLPl = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.aLPh = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.aMP = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.aJt = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.aJd = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.bLPl = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.bLPh = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.bMP = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.bJt = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
-
-            newCoeff.bJd = std::atof((tmpString.substr(0, tmpString.find(";"))).c_str());
-            tmpString = tmpString.erase(0, tmpString.find(";") + 1);
+linkMemoKey Calculation::createMemoKey(const int& satIndex, const double& latitude, const double& longitude,
+                                       const double& altitude) const
+{
+    linkMemoKey key;
+    key.satIndex = satIndex;
+    const SatSGP4Mobility* sat = userConfig->getSatMobility().at(satIndex);
+    key.satLatitude = sat->getLatitude();
+    key.satLongitude = sat->getLongitude();
+    key.satAltitude = sat->getAltitude();
+    key.latitude = static_cast< long long >(std::floor(latitude / memoResolution + 0.5));
+    key.longitude = static_cast< long long >(std::floor(longitude / memoResolution + 0.5));
+    key.altitude = altitude;
+    key.lambda = 0;
+    key.transmitterGain = 0;
+    key.receiverGain = 0;
+    key.transmitterPower = 0;
+    key.bandwidth = 0;
+    key.dG = 0;
+    key.tR = 0;
+    key.dR = 0;
+    return key;
+}
 
-            if (rainCoeffMap.find(newFreq) != rainCoeffMap.end()) {
-                EV << "Warning in FillRainMap: Duplicate entries in file for frequency \"" << newFreq
-                        << "\". Older entry is overwritten.";
-                rainCoeffMap.erase(newFreq);
-            }
+void Calculation::fillRainMap()
+{
+    rainTableFile = par("rainTableFile").stringValue();
 
-            // insert values into rainMap
-            rainCoeffMap.insert(rainCoeffMap.end(), std::pair< double, rainCoefficients >(newFreq, newCoeff));
-        }
+    if (!rainTable.load(rainTableFile)) {
+        error("Error in Calculation::fillRainMap: File not found!");
     }
-
-    fileStream.close();
 }
 
 void Calculation::handleMessage(cMessage* msg)
@@ -138,26 +163,77 @@ double Calculation::deg2rad(const double& rad)
 double Calculation::calcFSL(const int& satIndex,     const double& lambda,  const double& latitude,
                             const double& longitude, const double& altitude)
 {
-    SatSGP4Mobility* sat = userConfig->getSatMobility().at(satIndex);
+    linkMemoKey key;
+    if (memoEnabled) {
+        validateMemo();
+        key = createMemoKey(satIndex, latitude, longitude, altitude);
+        key.lambda = lambda;
+
+        std::map< linkMemoKey, double >::const_iterator memoIt = fslMemo.find(key);
+        if (memoIt != fslMemo.end()) {
+            fslMemoHits++;
+            return memoIt->second;
+        }
+        fslMemoMisses++;
+    }
 
-    double alt(0.0);
-    if (altitude == -9999)
-        alt = webserviceControl->getAltitudeData(latitude, longitude);
-    else
-        alt = altitude;
+    SatSGP4Mobility* sat = userConfig->getSatMobility().at(satIndex);
 
+    const double alt = getReferenceAltitude(latitude, longitude, altitude);
     const double distance = sat->getDistance(latitude, longitude, alt);
-    const double FSL = 20 * std::log10((4 * PI * distance) / (lambda / 1000)); // lambda in m <-> distance in km
-    return FSL;
+    const double fsl = LinkBudget::calcFSL(distance, lambda);
+
+    if (memoEnabled) {
+        fslMemo[key] = fsl;
+    }
+    return fsl;
+}
+
+double Calculation::getReferenceAltitude(const double& latitude, const double& longitude, const double& altitude)
+{
+    if (altitude == -9999)
+        return webserviceControl->getAltitudeData(latitude, longitude);
+    return altitude;
 }
 
 double Calculation::calcDistance(const double& latitude1, const double& longitude1,
                                  const double& latitude2, const double& longitude2)
 {
-    return EarthRadius * (std::acos(
-                  std::sin(deg2rad(latitude1)) * std::sin(deg2rad(latitude2)) +
-                  std::cos(deg2rad(latitude1)) * std::cos(deg2rad(latitude2)) *
-                  std::cos(deg2rad(longitude2 - longitude1))));
+    return LinkBudget::calcDistance(latitude1, longitude1, latitude2, longitude2);
+}
+
+unitVectors Calculation::calcUnitVectors(const std::vector< double >& latitudes, const std::vector< double >& longitudes)
+{
+    return LinkBudget::calcUnitVectors(latitudes, longitudes);
+}
+
+void Calculation::calcDistances(const double& latitude, const double& longitude, const unitVectors& stations,
+                                std::vector< double >& distances)
+{
+    LinkBudget::calcDistances(latitude, longitude, stations, distances);
+}
+
+void Calculation::calcDistances(const unitVectors& points, const unitVectors& stations, std::vector< double >& distances)
+{
+    LinkBudget::calcDistances(points, stations, distances);
+}
+
+const unitVectors& Calculation::getGroundStations()
+{
+    if (!groundStationsCollected) {
+        std::vector< std::pair< double, double > > locations;
+        WebServiceControl::collectStationLocations(simulation.getSystemModule(), locations);
+
+        std::vector< double > latitudes;
+        std::vector< double > longitudes;
+        for (std::size_t i = 0; i < locations.size(); i++) {
+            latitudes.push_back(locations[i].first);
+            longitudes.push_back(locations[i].second);
+        }
+        groundStations = LinkBudget::calcUnitVectors(latitudes, longitudes);
+        groundStationsCollected = true;
+    }
+    return groundStations;
 }
 
 double Calculation::calcSNR(const double& transmitterGain, const double& receiverGain, const double& transmitterPower,
@@ -165,56 +241,221 @@ double Calculation::calcSNR(const double& transmitterGain, const double& receive
                             const double& latitude,        const double& longitude,    const double& altitude,
                             const double& dG,              const double& tR,           const double& dR)
 {
+    carrierConfig carrier;
+    carrier.transmitterGain = transmitterGain;
+    carrier.receiverGain = receiverGain;
+    carrier.transmitterPower = transmitterPower;
+    carrier.lambda = lambda;
+    carrier.bandwidth = bandwidth;
+
+    linkMemoKey key;
+    if (memoEnabled) {
+        validateMemo();
+        key = createMemoKey(satIndex, latitude, longitude, altitude);
+        key.lambda = lambda;
+        key.transmitterGain = transmitterGain;
+        key.receiverGain = receiverGain;
+        key.transmitterPower = transmitterPower;
+        key.bandwidth = bandwidth;
+        key.dG = dG;
+        key.tR = tR;
+        key.dR = dR;
+
+        std::map< linkMemoKey, double >::const_iterator memoIt = snrMemo.find(key);
+        if (memoIt != snrMemo.end()) {
+            snrMemoHits++;
+            return memoIt->second;
+        }
+        snrMemoMisses++;
+    }
 
-    const double tB = 2.725;  // Cosmic microwave background in K +- 0.002K
-    const double tM = 270;    // Approximated atmospheric noise temperature in K
-    const double t0 = 290;    // Average temperature of earth surface in K
+    const double snr = calcSNR(calcLinkGeometry(satIndex, latitude, longitude, altitude), carrier, dG, tR, dR);
 
-    const double frequency = C / lambda; // In Hz
-    double alt(0.0);
-    if (altitude == -9999)
-        alt = webserviceControl->getAltitudeData(latitude, longitude);
-    else
-        alt = altitude;
+    if (memoEnabled) {
+        snrMemo[key] = snr;
+    }
+    return snr;
+}
+
+linkGeometry Calculation::calcLinkGeometry(const int& satIndex, const double& latitude, const double& longitude,
+                                           const double& altitude)
+{
+    linkMemoKey key;
+    if (memoEnabled) {
+        validateMemo();
+        key = createMemoKey(satIndex, latitude, longitude, altitude);
+
+        std::map< linkMemoKey, linkGeometry >::const_iterator memoIt = geometryMemo.find(key);
+        if (memoIt != geometryMemo.end()) {
+            geometryMemoHits++;
+            return memoIt->second;
+        }
+        geometryMemoMisses++;
+    }
 
-    const double elevation = userConfig->getSatMobility().at(satIndex)->getElevation(latitude, longitude, alt);
+    SatSGP4Mobility* sat = userConfig->getSatMobility().at(satIndex);
 
-    // Map frequency on listed frequencies given in rainCoeffMap
-    const double newFreq = getMappedFrequency(frequency / 1e9); // Frequency in map in GHz
+    linkGeometry geometry;
+    geometry.satIndex = satIndex;
+    geometry.altitude = getReferenceAltitude(latitude, longitude, altitude);
+    geometry.elevation = sat->getElevation(latitude, longitude, geometry.altitude);
+    geometry.distance = sat->getDistance(latitude, longitude, geometry.altitude);
+    geometry.precipPerHour = weatherControl->getPrecipPerHour(latitude, longitude);  // Current weather Data
 
-    // Get values from rainCoeffMap
-    std::map< double, rainCoefficients >::iterator rainCoeffMapIt = rainCoeffMap.find(newFreq);
+    if (memoEnabled) {
+        geometryMemo[key] = geometry;
+    }
+    return geometry;
+}
 
-    if (rainCoeffMapIt == rainCoeffMap.end()) {
-        error("Error in Calculation::calcSNR(): Frequency not found!");
-        return -1;
+const rainCoefficients& Calculation::getRainCoefficients(const double& lambda)
+{
+    const rainCoefficients* coefficients = rainTable.getCoefficients(lambda);
+    if (coefficients == nullptr) {
+        error("Error in Calculation::getRainCoefficients(): Frequency not found!");
     }
+    return *coefficients;
+}
 
-    const double a = rainCoeffMapIt->second.aMP;    // Coefficient a from table, using Marshall-Palmer distribution
-    const double b = rainCoeffMapIt->second.bMP;    // Coefficient b from table, using Marshall-Palmer distribution
-    const double rp = weatherControl->getPrecipPerHour(latitude, longitude);  // Current weather Data
+double Calculation::calcSNR(const linkGeometry& geometry, const carrierConfig& carrier,
+                            const double& dG, const double& tR, const double& dR)
+{
+    return LinkBudget::calcSNR(geometry, carrier, getRainCoefficients(carrier.lambda), dG, tR, dR);
+}
 
-    const double le = dR / std::sin(deg2rad(elevation));  // Length of signal path through rain
-    const double gammaR = a * std::pow(rp, b);            // Specific attenuation depending on frequency and rain density
-    const double aRain = gammaR * le;                     // Attenuation depending on weather
-    const double aRain_lin = std::pow(10, (aRain / 10));  // Transform aRain from dB to linear unit
+std::vector< double > Calculation::calcSNRSweep(const int& satIndex, const double& latitude, const double& longitude,
+                                                const std::vector< carrierConfig >& carriers, const double& altitude,
+                                                const double& dG, const double& tR, const double& dR)
+{
+    const linkGeometry geometry = calcLinkGeometry(satIndex, latitude, longitude, altitude);
 
-    // Noise temperature; source: 'Satellite Communications Systems', Maral et. Bousquet
-    const double tANoise = tB / aRain_lin + tM * (1 - 1 / aRain_lin) + t0 * dG;
+    std::vector< double > snrs;
+    snrs.reserve(carriers.size());
+    for (std::size_t i = 0; i < carriers.size(); i++) {
+        snrs.push_back(calcSNR(geometry, carriers[i], dG, tR, dR));
+    }
+    return snrs;
+}
 
-    const double tSysNoise = tANoise + tR;                // System noise temperature in K
-    const double tSdB = 10 * std::log10(tSysNoise);       // System noise temperature in dBK
+std::vector< std::vector< double > > Calculation::calcSNRMatrix(const std::vector< int >& satIndices,
+                                                                const double& latitude, const double& longitude,
+                                                                const std::vector< carrierConfig >& carriers,
+                                                                const double& altitude, const double& dG,
+                                                                const double& tR, const double& dR)
+{
+    std::vector< std::vector< double > > snrMatrix;
+    if (satIndices.empty()) {
+        return snrMatrix;
+    }
 
-    const double snr = transmitterPower
-                     + transmitterGain
-                     + receiverGain
-                     - tSdB
-                     - aRain
-                     - calcFSL(satIndex, lambda, latitude, longitude, altitude)
-                     - Boltzmann
-                     - 10 * std::log10(bandwidth);
+    // Altitude and weather only depend on the reference point => look them up once for all satellites
+    linkGeometry geometry = calcLinkGeometry(satIndices.front(), latitude, longitude, altitude);
+    const std::vector< SatSGP4Mobility* >& satmoVector = userConfig->getSatMobility();
+
+    snrMatrix.resize(satIndices.size());
+    for (std::size_t i = 0; i < satIndices.size(); i++) {
+        if (i > 0) {
+            SatSGP4Mobility* sat = satmoVector.at(satIndices[i]);
+            geometry.satIndex = satIndices[i];
+            geometry.elevation = sat->getElevation(latitude, longitude, geometry.altitude);
+            geometry.distance = sat->getDistance(latitude, longitude, geometry.altitude);
+        }
 
-    return snr;
+        snrMatrix[i].reserve(carriers.size());
+        for (std::size_t j = 0; j < carriers.size(); j++) {
+            snrMatrix[i].push_back(calcSNR(geometry, carriers[j], dG, tR, dR));
+        }
+    }
+    return snrMatrix;
+}
+
+void Calculation::updateSatelliteCache()
+{
+    // Satellites may move several times at the same simulation time, so the cache is checked against the
+    // current position of every satellite
+    const std::vector< SatSGP4Mobility* >& satmoVector = userConfig->getSatMobility();
+    if (satelliteLatitudes.size() != satmoVector.size()) {
+        satelliteLatitudes.assign(satmoVector.size(), std::numeric_limits< double >::quiet_NaN());
+        satelliteLongitudes.assign(satmoVector.size(), std::numeric_limits< double >::quiet_NaN());
+        satelliteAltitudes.assign(satmoVector.size(), std::numeric_limits< double >::quiet_NaN());
+        subSatellitePoints = unitVectors();
+        subSatellitePoints.x.resize(satmoVector.size());
+        subSatellitePoints.y.resize(satmoVector.size());
+        subSatellitePoints.z.resize(satmoVector.size());
+        horizonAngles.resize(satmoVector.size());
+    }
+
+    std::vector< double > latitude(1);
+    std::vector< double > longitude(1);
+    for (std::size_t i = 0; i < satmoVector.size(); i++) {
+        const double satLatitude = satmoVector[i]->getLatitude();
+        const double satLongitude = satmoVector[i]->getLongitude();
+        const double satAltitude = satmoVector[i]->getAltitude();
+        if (satLatitude == satelliteLatitudes[i] && satLongitude == satelliteLongitudes[i]
+                && satAltitude == satelliteAltitudes[i]) {
+            continue;
+        }
+        satelliteLatitudes[i] = satLatitude;
+        satelliteLongitudes[i] = satLongitude;
+        satelliteAltitudes[i] = satAltitude;
+
+        latitude[0] = satLatitude;
+        longitude[0] = satLongitude;
+        const unitVectors point = LinkBudget::calcUnitVectors(latitude, longitude);
+        subSatellitePoints.x[i] = point.x[0];
+        subSatellitePoints.y[i] = point.y[0];
+        subSatellitePoints.z[i] = point.z[0];
+        horizonAngles[i] = LinkBudget::calcHorizonAngle(satAltitude);
+    }
+}
+
+interferenceResult Calculation::calcInterference(const int& satIndex, const double& latitude, const double& longitude,
+                                                 const carrierConfig& carrier, const double& altitude,
+                                                 const double& discrimination, const double& dG,
+                                                 const double& tR, const double& dR)
+{
+    const linkGeometry geometry = calcLinkGeometry(satIndex, latitude, longitude, altitude);
+    const rainCoefficients& coefficients = getRainCoefficients(carrier.lambda);
+
+    const double carrierPower = LinkBudget::calcCarrierPower(geometry, carrier, coefficients, dR);
+    const double noisePower = LinkBudget::calcNoisePower(geometry, carrier, coefficients, dG, tR, dR);
+
+    // Ground distances from the terminal to all sub-satellite points in one pass
+    updateSatelliteCache();
+    std::vector< double > groundDistances;
+    LinkBudget::calcDistances(latitude, longitude, subSatellitePoints, groundDistances);
+
+    carrierConfig interfererCarrier = carrier;
+    interfererCarrier.receiverGain -= discrimination;
+    const double terminalHorizonAngle = LinkBudget::calcHorizonAngle(geometry.altitude);
+
+    const std::vector< SatSGP4Mobility* >& satmoVector = userConfig->getSatMobility();
+    std::vector< double > interferencePowers;
+    for (std::size_t i = 0; i < groundDistances.size(); i++) {
+        if (static_cast< int >(i) == satIndex) {
+            continue;
+        }
+
+        // Horizon-cone pruning: the terminal is outside the coverage cone of satellite i, widened by the horizon of
+        // the terminal itself (an elevated terminal sees beyond the horizon at sea level)
+        if (groundDistances[i] / LinkBudget::EarthRadius > horizonAngles[i] + terminalHorizonAngle) {
+            interferersPruned++;
+            continue;
+        }
+
+        linkGeometry interferer = geometry;
+        interferer.satIndex = static_cast< int >(i);
+        interferer.elevation = satmoVector[i]->getElevation(latitude, longitude, geometry.altitude);
+        interferer.distance = satmoVector[i]->getDistance(latitude, longitude, geometry.altitude);
+        interferersEvaluated++;
+
+        if (interferer.elevation <= 0) {
+            continue;
+        }
+        interferencePowers.push_back(LinkBudget::calcCarrierPower(interferer, interfererCarrier, coefficients, dR));
+    }
+
+    return LinkBudget::calcInterference(carrierPower, noisePower, interferencePowers);
 }
 
 int Calculation::getScoredSatfromSNR(const double& latitude, const double& longitude, const double& transmitterGain,
@@ -225,7 +466,7 @@ int Calculation::getScoredSatfromSNR(const double& latitude, const double& longi
     std::list< SAT > scoredSatList;
     std::vector< SatSGP4Mobility* > satmoVector = userConfig->getSatMobility();
     const int sat_count = userConfig->getParameters().numOfSats;
-    const double lambda = C / userConfig->getParameters().frequency;
+    const double lambda = LinkBudget::C / userConfig->getParameters().frequency;
 
     for (int index = 0; index < sat_count; index++) {
 
@@ -264,22 +505,5 @@ int Calculation::getScoredSatfromSNR(const double& latitude, const double& longi
 
 double Calculation::getMappedFrequency(const double& frequency)
 {
-    double mindist(-1);
-    double freq(0.0);
-
-    // Check if frequency already exists in map
-    if (rainCoeffMap.find(frequency) != rainCoeffMap.end()) {
-        return frequency;
-    }
-    else {
-        std::map< double, rainCoefficients >::iterator rainCoeffMapIt;
-        for (rainCoeffMapIt = rainCoeffMap.begin(); rainCoeffMapIt != rainCoeffMap.end(); rainCoeffMapIt++) {
-            const double dist = std::abs(frequency - rainCoeffMapIt->first); // Calculate euclidean distance
-            if (dist < mindist || mindist == -1) {
-                mindist = dist;
-                freq = rainCoeffMapIt->first;
-            }
-        }
-        return freq;
-    }
+    return rainTable.getMappedFrequency(frequency);
 }
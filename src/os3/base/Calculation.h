@@ -18,26 +18,36 @@
 
 #include <omnetpp.h>
 
-/** Source: 'The aR^b Relation in the Calculation of Rain Attenuation', Olsen and Rogers and Hodge
- * a and b are coefficients for different average dropsize distributions to calculate rain specific attenuation
- * LPl: Laws and Parsons Distribution - low rain rate
- * LPh: Laws and Parsons Distribution - high rain rate
- * MP: Marshall-Palmer Distribution
- * Jt: "Thunderstorm" Distribution
- * Jd: "Drizzle" Distribution
+#include <vector>
+
+#include "os3/base/LinkBudget.h"
+
+/**
+ * Key of the per-simulation-time memo table for link budget results
+ * - latitude and longitude are quantized (see parameter memoLocationResolution)
+ * - the carrier related members are zero for carrier independent entries (link geometry)
+ * - the satellite position is part of the key, so an update of the satellite later in the same
+ *   simulation time does not return results of the previous position
  */
-struct rainCoefficients
+struct linkMemoKey
 {
-    double aLPl;
-    double aLPh;
-    double aMP;
-    double aJt;
-    double aJd;
-    double bLPl;
-    double bLPh;
-    double bMP;
-    double bJt;
-    double bJd;
+    int satIndex;
+    double satLatitude;
+    double satLongitude;
+    double satAltitude;
+    long long latitude;
+    long long longitude;
+    double altitude;
+    double lambda;
+    double transmitterGain;
+    double receiverGain;
+    double transmitterPower;
+    double bandwidth;
+    double dG;
+    double tR;
+    double dR;
+
+    bool operator<(const linkMemoKey& other) const;
 };
 
 class UserConfig;
@@ -47,6 +57,8 @@ class WebServiceControl;
 //-----------------------------------------------------
 // Class: Calculation
 // Helper-class for calculating path loss, distances, etc.
+// The math itself is implemented by the stateless LinkBudget class, this module
+// gathers the inputs (satellite geometry, altitude, weather) from the simulation.
 //-----------------------------------------------------
 class Calculation : public cSimpleModule
 {
@@ -86,6 +98,33 @@ public:
     double calcDistance(const double& latitude1, const double& longitude1,
                         const double& latitude2, const double& longitude2);
 
+    /**
+     * Converts geographic coordinates into unit vectors. The result should be cached by the caller
+     * (e.g., once for all ground stations) and reused for the batch distance calculations.
+     * @param latitudes Latitudes of the points in degrees
+     * @param longitudes Longitudes of the points in degrees (same size as latitudes)
+     * @return Unit vectors of the given points
+     */
+    static unitVectors calcUnitVectors(const std::vector< double >& latitudes, const std::vector< double >& longitudes);
+
+    /**
+     * Calculates the great-circle distances between one point (e.g., a sub-satellite point) and N stations
+     * @param latitude Latitude of the point
+     * @param longitude Longitude of the point
+     * @param stations Precomputed unit vectors of the stations (see calcUnitVectors())
+     * @param distances Output: distances in km, distances[j] belongs to station j
+     */
+    void calcDistances(const double& latitude, const double& longitude, const unitVectors& stations,
+                       std::vector< double >& distances);
+
+    /**
+     * Calculates the great-circle distances between N points and M stations
+     * @param points Precomputed unit vectors of the points
+     * @param stations Precomputed unit vectors of the stations
+     * @param distances Output: N x M distances in km (row-major, distances[i * M + j] belongs to point i and station j)
+     */
+    void calcDistances(const unitVectors& points, const unitVectors& stations, std::vector< double >& distances);
+
     /**
      * Calculates the SNR for a transmission (in dBHz)
      * @param transmitterGain Gain of the transmitting antenna in dB
@@ -116,6 +155,94 @@ public:
             const double& tR = 150,
             const double& dR = 3);
 
+    /**
+     * Determines the carrier independent link state (elevation, distance, altitude and weather) once,
+     * such that it can be reused for several calls of calcSNR(const linkGeometry&, ...)
+     * @param satIndex Index of the satellite
+     * @param latitude Coordinate for the reference point
+     * @param longitude Coordinate for the reference point
+     * @param altitude Altitude of the reference point, default -9999 uses altitude data from webservice
+     * @return Geometry and weather state of the link
+     */
+    linkGeometry calcLinkGeometry(const int& satIndex, const double& latitude, const double& longitude,
+                                  const double& altitude = -9999);
+
+    /**
+     * Calculates the SNR for a transmission from a precomputed link geometry (no altitude or weather lookup)
+     * @param geometry Link state as returned by calcLinkGeometry()
+     * @param carrier Carrier configuration
+     * @param dG Average ratio of antenna radiation from ground, default 0.1
+     * @param tR Receiver noise temperature, default 150 K
+     * @param dR Highest point of rain area in km, default 3 is average for mild climate
+     * @return SNR in dB
+     */
+    double calcSNR(const linkGeometry& geometry, const carrierConfig& carrier,
+                   const double& dG = 0.1, const double& tR = 150, const double& dR = 3);
+
+    /**
+     * Evaluates a set of carrier configurations (e.g., a parameter sweep over frequency, power or gain)
+     * for one link. Geometry, altitude and weather are determined only once.
+     * @param satIndex Index of the satellite
+     * @param latitude Coordinate for the reference point
+     * @param longitude Coordinate for the reference point
+     * @param carriers Carrier configurations to evaluate
+     * @param altitude Altitude of the reference point, default -9999 uses altitude data from webservice
+     * @param dG Average ratio of antenna radiation from ground, default 0.1
+     * @param tR Receiver noise temperature, default 150 K
+     * @param dR Highest point of rain area in km, default 3 is average for mild climate
+     * @return SNR in dB for each carrier configuration (same order as carriers)
+     */
+    std::vector< double > calcSNRSweep(const int& satIndex, const double& latitude, const double& longitude,
+                                       const std::vector< carrierConfig >& carriers, const double& altitude = -9999,
+                                       const double& dG = 0.1, const double& tR = 150, const double& dR = 3);
+
+    /**
+     * Evaluates a set of carrier configurations for several satellites as seen from one reference point.
+     * Altitude and weather are looked up once, the geometry once per satellite.
+     * @param satIndices Indices of the satellites
+     * @param latitude Coordinate for the reference point
+     * @param longitude Coordinate for the reference point
+     * @param carriers Carrier configurations to evaluate
+     * @param altitude Altitude of the reference point, default -9999 uses altitude data from webservice
+     * @param dG Average ratio of antenna radiation from ground, default 0.1
+     * @param tR Receiver noise temperature, default 150 K
+     * @param dR Highest point of rain area in km, default 3 is average for mild climate
+     * @return Matrix of SNRs in dB, result[i][j] belongs to satellite satIndices[i] and carrier configuration carriers[j]
+     */
+    std::vector< std::vector< double > > calcSNRMatrix(const std::vector< int >& satIndices,
+                                                       const double& latitude, const double& longitude,
+                                                       const std::vector< carrierConfig >& carriers,
+                                                       const double& altitude = -9999, const double& dG = 0.1,
+                                                       const double& tR = 150, const double& dR = 3);
+
+    /**
+     * Calculates the aggregate co-channel interference a terminal receives while it is served by satIndex.
+     * All other satellites of the constellation are assumed to transmit on the same carrier. Satellites whose
+     * sub-satellite point is outside their horizon cone as seen from the terminal are pruned by a vectorized
+     * distance check over the per-simulation-time cached sub-satellite points, so the cost scales with the
+     * number of visible satellites.
+     * @param satIndex Index of the serving satellite
+     * @param latitude Coordinate for the terminal
+     * @param longitude Coordinate for the terminal
+     * @param carrier Carrier configuration, also used for the interfering satellites
+     * @param altitude Altitude of the terminal, default -9999 uses altitude data from webservice
+     * @param discrimination Antenna discrimination towards interferers in dB (subtracted from the receiver gain), default 0
+     * @param dG Average ratio of antenna radiation from ground, default 0.1
+     * @param tR Receiver noise temperature, default 150 K
+     * @param dR Highest point of rain area in km, default 3 is average for mild climate
+     * @return C/N, C/I and C/(N+I) of the link
+     */
+    interferenceResult calcInterference(const int& satIndex, const double& latitude, const double& longitude,
+                                        const carrierConfig& carrier, const double& altitude = -9999,
+                                        const double& discrimination = 0, const double& dG = 0.1,
+                                        const double& tR = 150, const double& dR = 3);
+
+    /**
+     * Returns the unit vectors of all ground stations of the network (LUTMotionMobility and Observer modules).
+     * The stations are collected at the first call, i.e., after all modules have been created.
+     */
+    const unitVectors& getGroundStations();
+
    /**
      * Determines the best-in-reach satellite depending on calculated SNR in dBHz
      * @param latitude Latitude of base station
@@ -149,24 +276,67 @@ protected:
 
     virtual void handleMessage(cMessage* msg);
 
-    // fills the rainCoeffMap with the Values from CSV file (default: data/TablespecRain.csv)
+    // records the hit/miss counters of the link memo table
+    virtual void finish();
+
+    // fills the rainTable with the Values from CSV file (default: data/TablespecRain.csv)
     void fillRainMap();
 
     // Maps the given frequency to an frequency existing in the table for RainCoefficients
     // frequency: frequency of used system
-    // returns nearest frequency existing in rainCoeffMap
+    // returns nearest frequency existing in rainTable
     double getMappedFrequency(const double& frequency);
 
-private:
+    // Returns the rain coefficients for the table entry nearest to the given wave length (in m)
+    const rainCoefficients& getRainCoefficients(const double& lambda);
+
+    // Returns the altitude of the reference point, fetched from the webservice if altitude is -9999
+    double getReferenceAltitude(const double& latitude, const double& longitude, const double& altitude);
 
-    static const double C;              // In m/s;
-    static const double Boltzmann;      // In dBWs/K
-    static const double EarthRadius;    // In km
+    // Creates a memo key for the given link; carrier dependent members are set to zero
+    linkMemoKey createMemoKey(const int& satIndex, const double& latitude, const double& longitude,
+                              const double& altitude) const;
+
+    // Clears the memo tables if the simulation time advanced since they were filled
+    void validateMemo();
+
+    // Refreshes the cached sub-satellite points and horizon angles of the satellites which moved
+    void updateSatelliteCache();
+
+
+private:
 
     std::string rainTableFile;
 
     // Used for calculation of specific rain attenuation
-    std::map< double, rainCoefficients > rainCoeffMap;
+    RainTable rainTable;
+
+    // Memo tables for link budget results, only valid for the simulation time memoTime
+    bool memoEnabled;
+    double memoResolution;
+    simtime_t memoTime;
+    std::map< linkMemoKey, linkGeometry > geometryMemo;
+    std::map< linkMemoKey, double > fslMemo;
+    std::map< linkMemoKey, double > snrMemo;
+    long geometryMemoHits;
+    long geometryMemoMisses;
+    long fslMemoHits;
+    long fslMemoMisses;
+    long snrMemoHits;
+    long snrMemoMisses;
+
+    // Sub-satellite points (unit vectors) and horizon angles of all satellites, valid for the cached positions
+    std::vector< double > satelliteLatitudes;
+    std::vector< double > satelliteLongitudes;
+    std::vector< double > satelliteAltitudes;
+    unitVectors subSatellitePoints;
+    std::vector< double > horizonAngles;
+    long interferersEvaluated;
+    long interferersPruned;
+
+    // Unit vectors of the ground stations, collected by getGroundStations()
+    bool groundStationsCollected;
+    unitVectors groundStations;
 
     UserConfig* userConfig;
     WeatherControl* weatherControl;
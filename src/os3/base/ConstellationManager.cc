@@ -0,0 +1,313 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/ConstellationManager.h"
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+
+#include "os3/base/TLECatalog.h"
+#include "os3/base/TLECatalogControl.h"
+#include "os3/libnorad/cNoradBase.h"
+#include "os3/libnorad/cOrbit.h"
+#include "os3/libnorad/cSite.h"
+#include "os3/libnorad/cTLE.h"
+
+Define_Module(ConstellationManager);
+
+// Size of an arena block; a block holds the orbit models of about 2000 near-earth satellites
+static const std::size_t arenaBlockSize = 1 << 20;
+
+ConstellationManager::ConstellationManager()
+{
+    catalog = nullptr;
+    tickTimer = nullptr;
+    numViews = 0;
+    compact = false;
+    arenaBlockUsed = arenaBlockSize;
+    stateValid = false;
+    numUpdates = 0;
+    propagationTime = 0;
+}
+
+ConstellationManager::~ConstellationManager()
+{
+    for (std::size_t i = 0; i < orbits.size(); i++) {
+        delete orbits[i];
+    }
+    for (std::size_t i = 0; i < models.size(); i++) {
+        models[i]->~cNoradBase();
+    }
+    for (std::size_t i = 0; i < arenaBlocks.size(); i++) {
+        delete[] arenaBlocks[i];
+    }
+}
+
+void ConstellationManager::initialize()
+{
+    fileName = par("TLEfile").stdstringValue();
+    updateInterval = par("updateInterval");
+    compact = par("compact").boolValue();
+    if (fileName == "") {
+        return;
+    }
+    if (updateInterval <= 0) {
+        error("Error in ConstellationManager::initialize(): updateInterval has to be positive.");
+    }
+
+    // The catalog and prebuilt orbits are shared with the Norad modules via the TLE catalog module
+    TLECatalogControl* catalogControl = dynamic_cast< TLECatalogControl* >(getParentModule()->getSubmodule("tleCatalog"));
+    if (catalogControl == nullptr) {
+        error("Error in ConstellationManager::initialize(): Could not find TLECatalogControl module.");
+    }
+    catalog = &catalogControl->getCatalog(fileName);
+
+    const long numSatellites = par("numSatellites").longValue();
+    const std::size_t count = (numSatellites >= 0 && static_cast< std::size_t >(numSatellites) < catalog->size())
+            ? numSatellites : catalog->size();
+
+    // Same start date as the Norad modules (current wall clock time)
+    std::time_t timestamp = std::time(nullptr);
+    std::tm* currentTime = std::gmtime(&timestamp);
+    startJulian = cJulian(currentTime->tm_year + 1900, currentTime->tm_mon + 1, currentTime->tm_mday,
+                          currentTime->tm_hour, currentTime->tm_min, 0);
+
+    if (compact) {
+        models.reserve(count);
+    } else {
+        orbits.reserve(count);
+    }
+    epoch.resize(count);
+    gap.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        if (catalogControl->getValidateChecksums() && !catalog->isValid(i)) {
+            error("Error in ConstellationManager::initialize(): TLE data of satellite %lu has an invalid checksum!",
+                  static_cast< unsigned long >(i));
+        }
+        cOrbit* orbit = catalogControl->takeOrbit(fileName, i);
+        if (orbit == nullptr) {
+            orbit = new cOrbit(catalog->getTle(i));
+        }
+        epoch[i] = orbit->Epoch();
+        gap[i] = orbit->TPlusEpoch(startJulian);
+
+        // The name is read from the catalog, the element set is not needed any more in compact mode
+        if (compact) {
+            models.push_back(addCompactModel(*orbit));
+            delete orbit;
+        } else {
+            orbits.push_back(orbit);
+        }
+    }
+
+    positionX.resize(count);
+    positionY.resize(count);
+    positionZ.resize(count);
+    velocityX.resize(count);
+    velocityY.resize(count);
+    velocityZ.resize(count);
+    latitude.resize(count);
+    longitude.resize(count);
+    altitude.resize(count);
+
+    update(simTime());
+    tickTimer = new cMessage("constellationTick");
+    scheduleAt(simTime() + updateInterval, tickTimer);
+
+    EV << "ConstellationManager: propagating " << count << " satellites of " << fileName << std::endl;
+}
+
+void ConstellationManager::handleMessage(cMessage* msg)
+{
+    if (msg != tickTimer) {
+        error("Error in ConstellationManager::handleMessage(): This module is not able to handle messages.");
+    }
+
+    // With attached views, their position updates drive the propagation
+    if (numViews > 0) {
+        delete tickTimer;
+        tickTimer = nullptr;
+        return;
+    }
+
+    update(simTime());
+    scheduleAt(simTime() + updateInterval, tickTimer);
+}
+
+void ConstellationManager::finish()
+{
+    if (tickTimer != nullptr) {
+        cancelAndDelete(tickTimer);
+        tickTimer = nullptr;
+    }
+    if (isEnabled()) {
+        const std::size_t memoryUsage = getMemoryUsage();
+        EV << "ConstellationManager: " << size() << " satellites use " << memoryUsage << " bytes ("
+           << memoryUsage / size() << " bytes per satellite" << (compact ? ", compact mode" : "") << ")" << std::endl;
+
+        recordScalar("constellationSatellites", size());
+        recordScalar("constellationUpdates", numUpdates);
+        recordScalar("constellationPropagationTime", propagationTime);
+        recordScalar("constellationMemory", memoryUsage);
+        recordScalar("constellationBytesPerSatellite", static_cast< double >(memoryUsage) / size());
+    }
+}
+
+cNoradBase* ConstellationManager::addCompactModel(const cOrbit& orbit)
+{
+    // Models are placed at multiples of the largest fundamental alignment, as by operator new
+    const std::size_t alignment = alignof(std::max_align_t);
+    const cNoradBase& model = orbit.getModel();
+    const std::size_t modelSize = (model.getSize() + alignment - 1) / alignment * alignment;
+
+    if (arenaBlockUsed + modelSize > arenaBlockSize) {
+        arenaBlocks.push_back(new char[arenaBlockSize]);
+        arenaBlockUsed = 0;
+    }
+    cNoradBase* copy = model.clone(arenaBlocks.back() + arenaBlockUsed);
+    arenaBlockUsed += modelSize;
+    return copy;
+}
+
+std::size_t ConstellationManager::getMemoryUsage() const
+{
+    std::size_t bytes = orbits.capacity() * sizeof(cOrbit*) + models.capacity() * sizeof(cNoradBase*)
+            + arenaBlocks.size() * arenaBlockSize + epoch.capacity() * sizeof(cJulian);
+    for (std::size_t i = 0; i < orbits.size(); i++) {
+        bytes += orbits[i]->getMemoryUsage();
+    }
+
+    const std::vector< double >* arrays[] = { &gap, &positionX, &positionY, &positionZ, &velocityX, &velocityY,
+                                              &velocityZ, &latitude, &longitude, &altitude };
+    for (std::size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        bytes += arrays[i]->capacity() * sizeof(double);
+    }
+    return bytes;
+}
+
+void ConstellationManager::update(const simtime_t& time)
+{
+    if (stateValid && time == stateTime) {
+        return;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const double seconds = time.dbl();
+    for (std::size_t i = 0; i < size(); i++) {
+        // A satellite whose orbit can not be propagated (e.g., decayed) keeps its last state, as in Norad
+        cEci eci;
+        const double tsince = (gap[i] + seconds) / 60;
+        if (compact) {
+            if (!models[i]->getPosition(tsince, eci)) {
+                continue;
+            }
+            eci.ae2km();
+        } else if (!orbits[i]->getPosition(tsince, &eci)) {
+            continue;
+        }
+        const cCoordGeo geo = eci.toGeo();  // converts eci to km-based units
+        const cVector pos = eci.getPos();
+        const cVector vel = eci.getVel();
+        positionX[i] = pos.m_x;
+        positionY[i] = pos.m_y;
+        positionZ[i] = pos.m_z;
+        velocityX[i] = vel.m_x;
+        velocityY[i] = vel.m_y;
+        velocityZ[i] = vel.m_z;
+        latitude[i] = geo.m_Lat;
+        longitude[i] = geo.m_Lon;
+        altitude[i] = geo.m_Alt;
+    }
+    propagationTime += std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+
+    stateTime = time;
+    stateValid = true;
+    numUpdates++;
+}
+
+long ConstellationManager::findSatellite(const long& catalogNumber, const std::string& satelliteName,
+                                         const long& moduleIndex) const
+{
+    if (catalog == nullptr) {
+        return -1;
+    }
+
+    long index;
+    if (catalogNumber >= 0) {
+        index = catalog->findByCatalogNumber(catalogNumber);
+    } else if (satelliteName != "") {
+        index = catalog->find(satelliteName);
+    } else {
+        index = moduleIndex;
+    }
+    return (index >= 0 && static_cast< std::size_t >(index) < size()) ? index : -1;
+}
+
+std::string ConstellationManager::getName(const std::size_t& index) const
+{
+    const std::string name = catalog->getName(index);
+    return name.substr(0, name.find("  "));
+}
+
+double ConstellationManager::getLatitude(const std::size_t& index) const
+{
+    return rad2deg(latitude[index]);
+}
+
+double ConstellationManager::getLongitude(const std::size_t& index) const
+{
+    return rad2deg(longitude[index]);
+}
+
+cEci ConstellationManager::getEci(const std::size_t& index) const
+{
+    // The date is calculated exactly as by the orbit models
+    cJulian date = epoch[index];
+    date.addMin((gap[index] + stateTime.dbl()) / 60);
+    cEci eci(cVector(positionX[index], positionY[index], positionZ[index]),
+             cVector(velocityX[index], velocityY[index], velocityZ[index]), date, false);
+    eci.setUnitsKm();
+    return eci;
+}
+
+double ConstellationManager::getElevation(const std::size_t& index, const double& refLatitude,
+                                          const double& refLongitude, const double& refAltitude) const
+{
+    cSite site(refLatitude, refLongitude, refAltitude);
+    cCoordTopo topoLook = site.getLookAngle(getEci(index));
+    if (topoLook.m_El == 0.0) {
+        error("Error in ConstellationManager::getElevation(): Corrupted database.");
+    }
+    return rad2deg(topoLook.m_El);
+}
+
+double ConstellationManager::getAzimuth(const std::size_t& index, const double& refLatitude,
+                                        const double& refLongitude, const double& refAltitude) const
+{
+    cSite site(refLatitude, refLongitude, refAltitude);
+    cCoordTopo topoLook = site.getLookAngle(getEci(index));
+    if (topoLook.m_El == 0.0) {
+        error("Error in ConstellationManager::getAzimuth(): Corrupted database.");
+    }
+    return rad2deg(topoLook.m_Az);
+}
+
+double ConstellationManager::getDistance(const std::size_t& index, const double& refLatitude,
+                                         const double& refLongitude, const double& refAltitude) const
+{
+    cSite site(refLatitude, refLongitude, refAltitude);
+    return site.getLookAngle(getEci(index)).m_Range;
+}
@@ -0,0 +1,144 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_ConstellationManager_H__
+#define __OS3_ConstellationManager_H__
+
+#include <omnetpp.h>
+
+#include <string>
+#include <vector>
+
+#include "os3/libnorad/cEci.h"
+#include "os3/libnorad/cJulian.h"
+
+class cNoradBase;
+class cOrbit;
+class TLECatalog;
+
+//-----------------------------------------------------
+// Class: ConstellationManager
+// Propagates all satellites of a TLE file centrally. The state of the satellites is
+// kept in structure-of-arrays form (one array per coordinate), all satellites are
+// advanced together by a single timer, and positions and link geometry are queried
+// by satellite index. Large constellations therefore need neither a Satellite module
+// nor a self-message per satellite. Scenarios which need per-satellite modules attach
+// SatSGP4Mobility modules as views (parameter constellationView); their position
+// updates then drive the propagation instead of the timer.
+// In compact mode, only the initialized orbit models are kept (copied into a
+// contiguous arena) instead of a full orbit with its element set per satellite.
+//-----------------------------------------------------
+class ConstellationManager : public cSimpleModule
+{
+public:
+    ConstellationManager();
+    virtual ~ConstellationManager();
+
+    // Whether a TLE file is configured and the satellites are propagated
+    bool isEnabled() const                                 { return !gap.empty(); }
+
+    // Number of satellites
+    std::size_t size() const                               { return gap.size(); }
+
+    /**
+     * Selects a satellite like Norad does: by catalog number, by name or by the index of the satellite module
+     * @param catalogNumber NORAD catalog number, -1 = not set
+     * @param satelliteName Name of the satellite, "" = not set
+     * @param moduleIndex Index of the satellite module
+     * @return Index of the satellite, -1 if it is not part of the constellation
+     */
+    long findSatellite(const long& catalogNumber, const std::string& satelliteName, const long& moduleIndex) const;
+
+    /**
+     * Propagates all satellites to a point in time; nothing is done if the state already belongs to this time
+     * @param time Simulation time
+     */
+    void update(const simtime_t& time);
+
+    // Attaches a per-satellite view; from now on, the views drive the propagation and the timer stops
+    void attachView()                                      { numViews++; }
+
+    // Simulation time the current state belongs to
+    simtime_t getStateTime() const                         { return stateTime; }
+
+    // Returns the name of satellite index (without padding blanks)
+    std::string getName(const std::size_t& index) const;
+
+    // Returns the latitude, longitude (in degrees) and altitude (in km) of satellite index
+    double getLatitude(const std::size_t& index) const;
+    double getLongitude(const std::size_t& index) const;
+    double getAltitude(const std::size_t& index) const     { return altitude[index]; }
+
+    // Returns the elevation and azimuth (in degrees) of satellite index seen from a reference point
+    double getElevation(const std::size_t& index, const double& refLatitude, const double& refLongitude,
+                        const double& refAltitude = -9999) const;
+    double getAzimuth(const std::size_t& index, const double& refLatitude, const double& refLongitude,
+                      const double& refAltitude = -9999) const;
+
+    // Returns the distance (in km) from a reference point to satellite index
+    double getDistance(const std::size_t& index, const double& refLatitude, const double& refLongitude,
+                       const double& refAltitude = -9999) const;
+
+protected:
+    virtual void initialize();
+
+    virtual void handleMessage(cMessage* msg);
+
+    virtual void finish();
+
+    // Returns the ECI state of satellite index at the state time (in km)
+    cEci getEci(const std::size_t& index) const;
+
+    // Copies the orbit model of orbit into the arena and returns the copy
+    cNoradBase* addCompactModel(const cOrbit& orbit);
+
+    // Memory used for the satellites in bytes (orbits or arena, state arrays)
+    std::size_t getMemoryUsage() const;
+
+private:
+    std::string fileName;
+    const TLECatalog* catalog;
+    cJulian startJulian;                 // wall clock time at the start of the simulation
+    simtime_t updateInterval;
+    cMessage* tickTimer;
+    unsigned int numViews;
+
+    // Compact mode: orbit models copied into fixed-size blocks, which are filled one after another
+    bool compact;
+    std::vector< char* > arenaBlocks;
+    std::size_t arenaBlockUsed;          // bytes used in the last block
+
+    // State of the satellites, element k of every array belongs to satellite k
+    std::vector< cOrbit* > orbits;       // empty in compact mode
+    std::vector< cNoradBase* > models;   // compact mode only, located in the arena
+    std::vector< cJulian > epoch;        // epoch of the element set
+    std::vector< double > gap;           // time between the epoch of the element set and the simulation start in s
+    std::vector< double > positionX;     // ECI position in km
+    std::vector< double > positionY;
+    std::vector< double > positionZ;
+    std::vector< double > velocityX;     // ECI velocity in km/s
+    std::vector< double > velocityY;
+    std::vector< double > velocityZ;
+    std::vector< double > latitude;      // in rad
+    std::vector< double > longitude;     // in rad
+    std::vector< double > altitude;      // in km
+    simtime_t stateTime;
+    bool stateValid;
+
+    unsigned long numUpdates;
+    double propagationTime;              // wall clock time spent propagating in s
+};
+
+#endif
@@ -0,0 +1,479 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/DataProvider.h"
+
+#include <omnetpp.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+/**
+ * @brief Conversion of cURL result to string
+ * This method transforms a cURL result set into a std::string value. The intention of this method is to reduce the cost for additional saves
+ * of result files on user's hard disk. The method is taken from http://www.c-plusplus.de/forum/262216
+ * @author Dennis Kaulbars
+ * @version 0.1
+ * Method defined
+ */
+static size_t write_data(char* ptr, size_t size, size_t nmemb, std::string* targetString)
+{
+    if (targetString) {
+        targetString->append(ptr, size * nmemb);
+        return size * nmemb;
+    }
+    return 0;
+}
+
+// Returns the value of a response header line if its name equals name (case insensitive), otherwise false
+static bool getHeaderValue(const std::string& line, const char* name, std::string& value)
+{
+    const std::size_t nameLength = std::strlen(name);
+    if (line.size() <= nameLength || line[nameLength] != ':') {
+        return false;
+    }
+    for (std::size_t i = 0; i < nameLength; i++) {
+        if (std::tolower(static_cast< unsigned char >(line[i])) != name[i]) {
+            return false;
+        }
+    }
+
+    const std::size_t begin = line.find_first_not_of(" \t", nameLength + 1);
+    const std::size_t end = line.find_last_not_of(" \t\r\n");
+    value = (begin != std::string::npos && end >= begin) ? line.substr(begin, end - begin + 1) : std::string();
+    return true;
+}
+
+// Stores the validators (ETag, Last-Modified) of a response in the request
+static size_t read_header(char* buffer, size_t size, size_t nitems, DataRequest* request)
+{
+    const std::string line(buffer, size * nitems);
+
+    // A new status line starts the headers of another response (e.g., after a redirect or "100 Continue")
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        request->etag.clear();
+        request->lastModified.clear();
+    } else if (!getHeaderValue(line, "etag", request->etag)) {
+        getHeaderValue(line, "last-modified", request->lastModified);
+    }
+    return size * nitems;
+}
+
+bool DataProvider::fetch(DataRequest& request)
+{
+    std::vector< DataRequest > requests(1, request);
+    fetchAll(requests);
+    request = requests[0];
+    return request.success;
+}
+
+double DataProvider::getWallClock()
+{
+    return std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+HttpDataProvider::HttpDataProvider(const unsigned int& maxParallelRequests, const long& connectTimeout,
+                                   const long& requestTimeout)
+    : maxParallelRequests(maxParallelRequests > 0 ? maxParallelRequests : 1), connectTimeout(connectTimeout),
+      requestTimeout(requestTimeout), timeLimit(0), numConnects(0), numNotModified(0)
+{
+    // DNS and connection cache shared by all easy handles of this provider; each provider is only used by one thread
+    // (the simulation or the weather refresh thread), so no locks are needed
+    shareHandle = curl_share_init();
+    curl_share_setopt(shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+
+HttpDataProvider::~HttpDataProvider()
+{
+    for (std::size_t i = 0; i < handlePool.size(); i++) {
+        curl_easy_cleanup(handlePool[i]);
+    }
+    handlePool.clear();
+
+    if (shareHandle != nullptr) {
+        curl_share_cleanup(shareHandle);
+    }
+}
+
+CURL* HttpDataProvider::acquireHandle(DataRequest& request)
+{
+    CURL* easyHandle;
+    if (handlePool.empty()) {
+        easyHandle = curl_easy_init();
+    } else {
+        // Reset the options of the last request, open connections and caches of the handle are kept
+        easyHandle = handlePool.back();
+        handlePool.pop_back();
+        curl_easy_reset(easyHandle);
+    }
+
+    curl_easy_setopt(easyHandle, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(easyHandle, CURLOPT_WRITEDATA, &request.result);
+    curl_easy_setopt(easyHandle, CURLOPT_WRITEFUNCTION, &write_data);
+    curl_easy_setopt(easyHandle, CURLOPT_HEADERDATA, &request);
+    curl_easy_setopt(easyHandle, CURLOPT_HEADERFUNCTION, &read_header);
+    curl_easy_setopt(easyHandle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT_MS, connectTimeout);
+    curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT_MS, requestTimeout);
+    curl_easy_setopt(easyHandle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easyHandle, CURLOPT_ACCEPT_ENCODING, "");  // all encodings supported by the cURL build
+    if (shareHandle != nullptr) {
+        curl_easy_setopt(easyHandle, CURLOPT_SHARE, shareHandle);
+    }
+
+    // Conditional request: the web service answers "304 Not Modified" without a body if the version is current
+    curl_slist* headers = nullptr;
+    if (!request.etag.empty()) {
+        headers = curl_slist_append(headers, ("If-None-Match: " + request.etag).c_str());
+    }
+    if (!request.lastModified.empty()) {
+        headers = curl_slist_append(headers, ("If-Modified-Since: " + request.lastModified).c_str());
+    }
+    if (headers != nullptr) {
+        curl_easy_setopt(easyHandle, CURLOPT_HTTPHEADER, headers);
+        headerLists[easyHandle] = headers;
+    }
+
+    request.result.clear();
+    request.success = false;
+    request.notModified = false;
+    numRequests++;
+    return easyHandle;
+}
+
+bool HttpDataProvider::limitTimeouts(CURL* easyHandle, const double& deadline) const
+{
+    if (timeLimit <= 0) {
+        return true;
+    }
+
+    const long remaining = static_cast< long >((deadline - getWallClock()) * 1000);
+    if (remaining <= 0) {
+        return false;
+    }
+    curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT_MS, (connectTimeout > 0) ? std::min(connectTimeout, remaining) : remaining);
+    curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT_MS, (requestTimeout > 0) ? std::min(requestTimeout, remaining) : remaining);
+    return true;
+}
+
+void HttpDataProvider::releaseHandle(CURL* easyHandle)
+{
+    std::map< CURL*, curl_slist* >::iterator it = headerLists.find(easyHandle);
+    if (it != headerLists.end()) {
+        curl_easy_setopt(easyHandle, CURLOPT_HTTPHEADER, nullptr);
+        curl_slist_free_all(it->second);
+        headerLists.erase(it);
+    }
+
+    long connects = 0;
+    if (curl_easy_getinfo(easyHandle, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK) {
+        numConnects += connects;
+    }
+    handlePool.push_back(easyHandle);
+}
+
+bool HttpDataProvider::fetch(DataRequest& request)
+{
+    const double deadline = getWallClock() + timeLimit;
+    CURL* easyHandle = acquireHandle(request);
+    if (!limitTimeouts(easyHandle, deadline)) {
+        releaseHandle(easyHandle);
+        return false;
+    }
+
+    const CURLcode code = curl_easy_perform(easyHandle);
+    long responseCode = 0;
+    curl_easy_getinfo(easyHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+    releaseHandle(easyHandle);
+
+    if (code != CURLE_OK) {
+        EV << "Warning in HttpDataProvider::fetch(): " << curl_easy_strerror(code) << " (" << request.url << ")"
+           << std::endl;
+        request.success = false;
+        return false;
+    }
+    finishRequest(request, true, responseCode);
+    return request.success;
+}
+
+void HttpDataProvider::finishRequest(DataRequest& request, const bool& transferred, const long& responseCode)
+{
+    request.success = transferred && (responseCode < 400);
+    request.notModified = transferred && (responseCode == 304);
+    if (request.notModified) {
+        numNotModified++;
+    }
+}
+
+void HttpDataProvider::fetchAll(std::vector< DataRequest >& requests)
+{
+    const double deadline = getWallClock() + timeLimit;
+    CURLM* multiHandle = curl_multi_init();
+    std::map< CURL*, DataRequest* > activeRequests;
+    std::size_t nextRequest = 0;
+    int runningHandles = 0;
+
+    do {
+        // Keep at most maxParallelRequests transfers running
+        while (nextRequest < requests.size() && activeRequests.size() < maxParallelRequests) {
+            DataRequest* request = &requests[nextRequest++];
+
+            // Requests which can not be completed before the deadline are not started
+            CURL* easyHandle = acquireHandle(*request);
+            if (!limitTimeouts(easyHandle, deadline)) {
+                releaseHandle(easyHandle);
+                continue;
+            }
+            curl_multi_add_handle(multiHandle, easyHandle);
+            activeRequests[easyHandle] = request;
+        }
+
+        curl_multi_perform(multiHandle, &runningHandles);
+
+        // Collect finished transfers
+        int messagesLeft = 0;
+        CURLMsg* message;
+        while ((message = curl_multi_info_read(multiHandle, &messagesLeft)) != nullptr) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL* easyHandle = message->easy_handle;
+            DataRequest* request = activeRequests[easyHandle];
+            long responseCode = 0;
+            curl_easy_getinfo(easyHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+            finishRequest(*request, message->data.result == CURLE_OK, responseCode);
+
+            curl_multi_remove_handle(multiHandle, easyHandle);
+            releaseHandle(easyHandle);
+            activeRequests.erase(easyHandle);
+        }
+
+        // Wait for activity on any of the connections
+        if (!activeRequests.empty()) {
+            curl_multi_wait(multiHandle, nullptr, 0, 100, nullptr);
+        }
+    } while (!activeRequests.empty() || nextRequest < requests.size());
+
+    curl_multi_cleanup(multiHandle);
+}
+
+CircuitBreakerDataProvider::CircuitBreakerDataProvider(DataProvider* source, const unsigned int& failureThreshold,
+                                                       const double& backoff, const double& maxBackoff,
+                                                       const double& latencyBudget)
+    : source(source), failureThreshold(failureThreshold), initialBackoff(backoff), maxBackoff(std::max(backoff, maxBackoff)),
+      latencyBudget(latencyBudget), totalWaitTime(0), numOpened(0), numHalfOpened(0), numRejected(0)
+{
+    for (int i = 0; i < 3; i++) {
+        breakers[i].state = CLOSED;
+        breakers[i].failures = 0;
+        breakers[i].backoff = initialBackoff;
+        breakers[i].retryTime = 0;
+    }
+}
+
+CircuitBreakerDataProvider::~CircuitBreakerDataProvider()
+{
+    delete source;
+}
+
+double CircuitBreakerDataProvider::getRemainingBudget() const
+{
+    if (latencyBudget <= 0) {
+        return std::numeric_limits< double >::infinity();
+    }
+    return std::max(0.0, latencyBudget - totalWaitTime);
+}
+
+bool CircuitBreakerDataProvider::allowRequest(breakerState& breaker, const double& now)
+{
+    switch (breaker.state) {
+        case CLOSED:
+            return true;
+        case OPEN:
+            // After the backoff time, a single trial request is let through
+            if (now >= breaker.retryTime) {
+                breaker.state = HALF_OPEN;
+                numHalfOpened++;
+                return true;
+            }
+            return false;
+        case HALF_OPEN:
+            return false;
+    }
+    return false;
+}
+
+void CircuitBreakerDataProvider::reportResult(breakerState& breaker, const bool& success, const double& now)
+{
+    if (success) {
+        breaker.state = CLOSED;
+        breaker.failures = 0;
+        breaker.backoff = initialBackoff;
+        return;
+    }
+
+    breaker.failures++;
+    if (breaker.state == OPEN || failureThreshold == 0) {
+        return;
+    }
+    if (breaker.state == HALF_OPEN || breaker.failures >= failureThreshold) {
+        breaker.state = OPEN;
+        breaker.retryTime = now + breaker.backoff;
+        breaker.backoff = std::min(2 * breaker.backoff, maxBackoff);
+        numOpened++;
+    }
+}
+
+void CircuitBreakerDataProvider::fetchAll(std::vector< DataRequest >& requests)
+{
+    const double start = getWallClock();
+    const double remaining = getRemainingBudget();
+
+    // Reject the requests to open services and all requests if the budget is used up
+    std::vector< std::size_t > forwarded;
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        requests[i].success = false;
+        requests[i].notModified = false;
+        requests[i].result.clear();
+        if (remaining >= 0.001 && allowRequest(breakers[requests[i].type], start)) {
+            forwarded.push_back(i);
+        } else {
+            numRejected++;
+        }
+        numRequests++;
+    }
+    if (forwarded.empty()) {
+        return;
+    }
+
+    std::vector< DataRequest > batch;
+    batch.reserve(forwarded.size());
+    for (std::size_t i = 0; i < forwarded.size(); i++) {
+        batch.push_back(requests[forwarded[i]]);
+    }
+
+    source->setTimeLimit(latencyBudget > 0 ? remaining : 0);
+    source->fetchAll(batch);
+    const double now = getWallClock();
+    totalWaitTime += now - start;
+
+    for (std::size_t i = 0; i < forwarded.size(); i++) {
+        reportResult(breakers[batch[i].type], batch[i].success, now);
+        requests[forwarded[i]] = batch[i];
+    }
+}
+
+FileDataProvider::FileDataProvider(const std::string& directory)
+    : directory(directory)
+{
+}
+
+std::string FileDataProvider::getFileName(const std::string& directory, const DataRequest& request)
+{
+    std::ostringstream fileNameStream;
+    fileNameStream << directory << "/";
+    switch (request.type) {
+        case DataRequest::WEATHER:
+            fileNameStream << "weather_" << request.latitude << "_" << request.longitude << ".csv";
+            break;
+        case DataRequest::ALTITUDE:
+            fileNameStream << "altitude_" << request.latitude << "_" << request.longitude << ".txt";
+            break;
+        case DataRequest::TLE:
+            fileNameStream << request.fileName;
+            break;
+    }
+    return fileNameStream.str();
+}
+
+void FileDataProvider::fetchAll(std::vector< DataRequest >& requests)
+{
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        DataRequest& request = requests[i];
+        request.result.clear();
+        request.notModified = false;
+
+        std::ifstream fileStream(getFileName(directory, request).c_str(), std::ios::binary);
+        request.success = fileStream.good();
+        if (request.success) {
+            std::ostringstream content;
+            content << fileStream.rdbuf();
+            request.result = content.str();
+        }
+        numRequests++;
+    }
+}
+
+RecordingDataProvider::RecordingDataProvider(DataProvider* source, const std::string& directory)
+    : source(source), directory(directory)
+{
+}
+
+RecordingDataProvider::~RecordingDataProvider()
+{
+    delete source;
+}
+
+void RecordingDataProvider::fetchAll(std::vector< DataRequest >& requests)
+{
+    // A recording needs the complete responses, so no conditional requests are sent
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        requests[i].etag.clear();
+        requests[i].lastModified.clear();
+    }
+    source->fetchAll(requests);
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        if (requests[i].success) {
+            record(requests[i]);
+        }
+        numRequests++;
+    }
+}
+
+bool RecordingDataProvider::fetch(DataRequest& request)
+{
+    request.etag.clear();
+    request.lastModified.clear();
+    if (source->fetch(request)) {
+        record(request);
+    }
+    numRequests++;
+    return request.success;
+}
+
+void RecordingDataProvider::record(const DataRequest& request) const
+{
+    // Write to a temporary file first, so a replay never reads a partially written response
+    const std::string fileName = FileDataProvider::getFileName(directory, request);
+    const std::string tempName = fileName + ".tmp";
+    std::ofstream fileStream(tempName.c_str(), std::ios::binary | std::ios::trunc);
+    fileStream << request.result;
+    fileStream.close();
+    if (!fileStream.good() || std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+        std::remove(tempName.c_str());
+        EV << "Warning in RecordingDataProvider::record(): Could not write " << fileName << std::endl;
+    }
+}
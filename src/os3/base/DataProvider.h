@@ -0,0 +1,290 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_DataProvider_H__
+#define __OS3_DataProvider_H__
+
+#include <curl/curl.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * One request for web service data (weather data or altitude of a location, or a TLE file)
+ */
+struct DataRequest
+{
+    enum Type { WEATHER, ALTITUDE, TLE };
+
+    Type type;
+    double latitude;       // Location of weather and altitude requests in degrees
+    double longitude;
+    std::string fileName;  // File name of TLE requests
+    std::string url;       // URL of the request at the web service
+    std::string result;    // Raw response
+    bool success;
+
+    // Validators of the version the caller already has; if set, the HTTP provider sends a conditional request.
+    // Afterwards, they contain the validators of the response (empty if the web service did not send them).
+    std::string etag;
+    std::string lastModified;
+    bool notModified;      // The web service confirmed that the version of the caller is current (result is empty)
+};
+
+//-----------------------------------------------------
+// Class: DataProvider
+// Source of the raw web service data used by WebServiceControl. The backends
+// are interchangeable: live HTTP requests, local files, and recording of the
+// live responses which are replayed by a file provider later on.
+//-----------------------------------------------------
+class DataProvider
+{
+public:
+    DataProvider() : numRequests(0) {}
+    virtual ~DataProvider() {}
+
+    /**
+     * Fetches the raw responses of all requests
+     * @param requests Requests; result and success are set for each request
+     */
+    virtual void fetchAll(std::vector< DataRequest >& requests) = 0;
+
+    /**
+     * Fetches the raw response of a single request
+     * @return Whether the request succeeded
+     */
+    virtual bool fetch(DataRequest& request);
+
+    /**
+     * Limits the time the following fetch calls may block; providers without network access ignore the limit
+     * @param timeLimit Time limit in s, 0 = no limit
+     */
+    virtual void setTimeLimit(const double& timeLimit)     {}
+
+    // Whether responses fetched by other providers may be used instead of fetching the requests with this provider
+    virtual bool sharesResponses() const                   { return true; }
+
+    // Number of requests answered by the provider
+    unsigned int getNumRequests() const                    { return numRequests; }
+
+    // Current wall clock time in s (monotonic)
+    static double getWallClock();
+
+protected:
+    unsigned int numRequests;
+};
+
+//-----------------------------------------------------
+// Class: HttpDataProvider
+// Fetches the data from the web services with pooled cURL handles. Pooled
+// handles keep their connections alive, and all handles share one DNS and
+// connection cache, so consecutive requests to the same host do not pay DNS,
+// TCP and TLS setup again. Batches are transferred concurrently.
+//-----------------------------------------------------
+class HttpDataProvider : public DataProvider
+{
+public:
+    /**
+     * @param maxParallelRequests Maximum number of concurrent transfers of a batch
+     * @param connectTimeout Connect timeout in ms, 0 = no timeout
+     * @param requestTimeout Timeout of a complete request in ms, 0 = no timeout
+     */
+    HttpDataProvider(const unsigned int& maxParallelRequests, const long& connectTimeout, const long& requestTimeout);
+    virtual ~HttpDataProvider();
+
+    virtual void fetchAll(std::vector< DataRequest >& requests);
+
+    virtual bool fetch(DataRequest& request);
+
+    virtual void setTimeLimit(const double& timeLimit)     { this->timeLimit = timeLimit; }
+
+    // Number of connections opened (requests on reused connections do not count)
+    long getNumConnects() const                            { return numConnects; }
+
+    // Number of conditional requests answered with "304 Not Modified"
+    long getNumNotModified() const                         { return numNotModified; }
+
+private:
+    // The provider owns cURL handles
+    HttpDataProvider(const HttpDataProvider&);
+    HttpDataProvider& operator=(const HttpDataProvider&);
+
+    /**
+     * Takes an easy handle from the pool (or creates one) and configures it for a request
+     * (including the conditional headers if the request has validators)
+     * @param request Request; the response body and validators are written to it
+     * @return Configured easy handle, has to be given back with releaseHandle()
+     */
+    CURL* acquireHandle(DataRequest& request);
+
+    // Evaluates the response code of a finished transfer
+    void finishRequest(DataRequest& request, const bool& transferred, const long& responseCode);
+
+    // Gives an easy handle back to the pool
+    void releaseHandle(CURL* easyHandle);
+
+    /**
+     * Shortens the timeouts of a handle such that the transfer ends before deadline
+     * @return false if the deadline has already passed
+     */
+    bool limitTimeouts(CURL* easyHandle, const double& deadline) const;
+
+    unsigned int maxParallelRequests;
+    long connectTimeout;                 // in ms, 0 = no timeout
+    long requestTimeout;                 // in ms, 0 = no timeout
+    double timeLimit;                    // in s, 0 = no limit
+    CURLSH* shareHandle;                 // shared DNS and connection cache
+    std::vector< CURL* > handlePool;     // idle easy handles
+    std::map< CURL*, curl_slist* > headerLists;  // conditional headers of the active handles
+    long numConnects;
+    long numNotModified;
+};
+
+//-----------------------------------------------------
+// Class: CircuitBreakerDataProvider
+// Protects the simulation against unreachable web services. Every service
+// (weather, altitude, TLE) has a circuit breaker: after a number of consecutive
+// failures the service is not contacted anymore (open) until a backoff time has
+// passed; then a single trial request is let through (half-open), which closes
+// the breaker on success or opens it again with a doubled backoff. In addition,
+// the total time spent waiting for the source is limited by a latency budget.
+// Rejected requests fail immediately, so the caller falls back to cached or
+// default values.
+//-----------------------------------------------------
+class CircuitBreakerDataProvider : public DataProvider
+{
+public:
+    /**
+     * @param source Provider the data is fetched from (owned by the circuit breaker)
+     * @param failureThreshold Consecutive failures after which a breaker opens, 0 = breakers never open
+     * @param backoff Initial backoff time in s
+     * @param maxBackoff Maximum backoff time in s
+     * @param latencyBudget Maximum total time in s spent waiting for the source, 0 = unlimited
+     */
+    CircuitBreakerDataProvider(DataProvider* source, const unsigned int& failureThreshold, const double& backoff,
+                               const double& maxBackoff, const double& latencyBudget);
+    virtual ~CircuitBreakerDataProvider();
+
+    virtual void fetchAll(std::vector< DataRequest >& requests);
+
+    // Remaining latency budget in s (infinity if the budget is unlimited)
+    double getRemainingBudget() const;
+
+    // Charges time spent waiting for the network outside of fetchAll() (e.g., URL checks) to the budget
+    void addWaitTime(const double& waitTime)               { totalWaitTime += waitTime; }
+
+    double getTotalWaitTime() const                        { return totalWaitTime; }
+    unsigned long getNumOpened() const                     { return numOpened; }
+    unsigned long getNumHalfOpened() const                 { return numHalfOpened; }
+    unsigned long getNumRejected() const                   { return numRejected; }
+
+private:
+    enum State { CLOSED, OPEN, HALF_OPEN };
+
+    // Circuit breaker of one service
+    struct breakerState
+    {
+        State state;
+        unsigned int failures;   // consecutive failures
+        double backoff;          // backoff time after the next failure in s
+        double retryTime;        // wall clock time at which an open breaker becomes half-open
+    };
+
+    CircuitBreakerDataProvider(const CircuitBreakerDataProvider&);
+    CircuitBreakerDataProvider& operator=(const CircuitBreakerDataProvider&);
+
+    // Decides whether a request to the service of breaker may be sent
+    bool allowRequest(breakerState& breaker, const double& now);
+
+    // Updates a breaker with the result of a request
+    void reportResult(breakerState& breaker, const bool& success, const double& now);
+
+    DataProvider* source;
+    unsigned int failureThreshold;
+    double initialBackoff;
+    double maxBackoff;
+    double latencyBudget;
+    double totalWaitTime;
+    breakerState breakers[3];    // indexed by DataRequest::Type
+    unsigned long numOpened;
+    unsigned long numHalfOpened;
+    unsigned long numRejected;
+};
+
+//-----------------------------------------------------
+// Class: FileDataProvider
+// Reads the data from local files (no network access, no latency). The files
+// are named after the request (see getFileName()), which is also the layout
+// written by RecordingDataProvider. A missing file fails the request.
+//-----------------------------------------------------
+class FileDataProvider : public DataProvider
+{
+public:
+    /**
+     * @param directory Directory of the data files
+     */
+    explicit FileDataProvider(const std::string& directory);
+
+    virtual void fetchAll(std::vector< DataRequest >& requests);
+
+    /**
+     * Returns the file of a request:
+     * TLE files: directory/fileName, weather data: directory/weather_<latitude>_<longitude>.csv,
+     * altitude data: directory/altitude_<latitude>_<longitude>.txt
+     */
+    static std::string getFileName(const std::string& directory, const DataRequest& request);
+
+private:
+    std::string directory;
+};
+
+//-----------------------------------------------------
+// Class: RecordingDataProvider
+// Fetches the data from another provider (usually HTTP) and stores every
+// successful response in the layout of FileDataProvider, such that the run
+// can be replayed without network access.
+//-----------------------------------------------------
+class RecordingDataProvider : public DataProvider
+{
+public:
+    /**
+     * @param source Provider the data is fetched from (owned by the recording provider)
+     * @param directory Directory the responses are stored in
+     */
+    RecordingDataProvider(DataProvider* source, const std::string& directory);
+    virtual ~RecordingDataProvider();
+
+    virtual void fetchAll(std::vector< DataRequest >& requests);
+
+    virtual bool fetch(DataRequest& request);
+
+    // Every response has to pass the recording, so responses of other providers are not used
+    virtual bool sharesResponses() const                   { return false; }
+
+    const DataProvider* getSource() const                  { return source; }
+
+private:
+    RecordingDataProvider(const RecordingDataProvider&);
+    RecordingDataProvider& operator=(const RecordingDataProvider&);
+
+    // Stores the response of a request
+    void record(const DataRequest& request) const;
+
+    DataProvider* source;
+    std::string directory;
+};
+
+#endif
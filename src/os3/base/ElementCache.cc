@@ -0,0 +1,215 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/ElementCache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "os3/base/TLECatalog.h"
+#include "os3/libnorad/cOrbit.h"
+
+const unsigned int ElementCache::Version = 1;
+
+namespace {
+
+const char Magic[8] = { 'O', 'S', '3', 'E', 'L', 'E', 'M', '\0' };
+const std::size_t HeaderSize = 48;
+const std::uint64_t HashSeed = 14695981039346656037ULL;
+
+// FNV-1a style hash over 64 bit words (the payload is hashed while it is encoded or decoded)
+std::uint64_t hashWord(const std::uint64_t& hash, const std::uint64_t& word)
+{
+    return (hash ^ word) * 1099511628211ULL;
+}
+
+void writeUint64(std::vector< unsigned char >& buffer, std::uint64_t value)
+{
+    for (int i = 0; i < 8; i++) {
+        buffer.push_back(static_cast< unsigned char >(value >> (8 * i)));
+    }
+}
+
+std::uint64_t readUint64(const unsigned char* buffer)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= static_cast< std::uint64_t >(buffer[i]) << (8 * i);
+    }
+    return value;
+}
+
+std::uint64_t doubleToBits(const double& value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsToDouble(const std::uint64_t& bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool isLittleEndian()
+{
+    const std::uint16_t value = 1;
+    unsigned char firstByte;
+    std::memcpy(&firstByte, &value, 1);
+    return firstByte == 1;
+}
+
+void deleteOrbits(std::vector< cOrbit* >& orbits)
+{
+    for (std::size_t i = 0; i < orbits.size(); i++) {
+        delete orbits[i];
+    }
+    orbits.clear();
+}
+
+}
+
+bool ElementCache::save(const std::string& fileName, const TLECatalog& catalog, const std::vector< cOrbit* >& orbits)
+{
+    if (orbits.size() != catalog.size()) {
+        return false;
+    }
+
+    std::vector< std::uint64_t > offsets;
+    std::vector< unsigned char > payload;
+    std::vector< double > state;
+    std::uint64_t payloadHash = HashSeed;
+    offsets.push_back(0);
+    for (std::size_t i = 0; i < orbits.size(); i++) {
+        if (orbits[i] == nullptr) {
+            return false;
+        }
+        state.clear();
+        orbits[i]->saveState(state);
+        for (std::size_t j = 0; j < state.size(); j++) {
+            const std::uint64_t bits = doubleToBits(state[j]);
+            writeUint64(payload, bits);
+            payloadHash = hashWord(payloadHash, bits);
+        }
+        offsets.push_back(offsets.back() + state.size());
+    }
+
+    std::vector< unsigned char > header(Magic, Magic + sizeof(Magic));
+    writeUint64(header, Version);  // version (uint32) and reserved (uint32)
+    writeUint64(header, catalog.getContentHash());
+    writeUint64(header, catalog.getContentSize());
+    writeUint64(header, catalog.size());
+    writeUint64(header, payloadHash);
+    for (std::size_t i = 0; i < offsets.size(); i++) {
+        writeUint64(header, offsets[i]);
+    }
+
+    const std::string tempName = fileName + ".tmp" + std::to_string(static_cast< long >(getpid()));
+    std::ofstream fileStream(tempName.c_str(), std::ios::binary | std::ios::trunc);
+    fileStream.write(reinterpret_cast< const char* >(header.data()), header.size());
+    fileStream.write(reinterpret_cast< const char* >(payload.data()), payload.size());
+    fileStream.close();
+    if (!fileStream.good() || std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ElementCache::load(const std::string& fileName, const TLECatalog& catalog, std::vector< cOrbit* >& orbits)
+{
+    orbits.clear();
+
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast< off_t >(HeaderSize)) {
+        close(fd);
+        return false;
+    }
+    const std::size_t fileSize = fileStat.st_size;
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const unsigned char* buffer = static_cast< const unsigned char* >(mapping);
+
+    // Check the header against the catalog
+    const std::uint64_t numRecords = readUint64(buffer + 32);
+    const std::size_t offsetsSize = (numRecords + 1) * 8;
+    bool ok = std::memcmp(buffer, Magic, sizeof(Magic)) == 0
+           && readUint64(buffer + 8) == Version
+           && readUint64(buffer + 16) == catalog.getContentHash()
+           && readUint64(buffer + 24) == catalog.getContentSize()
+           && numRecords == catalog.size()
+           && fileSize >= HeaderSize + offsetsSize;
+
+    const unsigned char* payload = buffer + HeaderSize + offsetsSize;
+    const std::size_t payloadSize = ok ? fileSize - HeaderSize - offsetsSize : 0;
+    ok = ok && readUint64(buffer + HeaderSize + numRecords * 8) * 8 == payloadSize;
+
+    // Decode the payload (if necessary) and verify its hash before any state is used
+    const std::size_t numValues = payloadSize / 8;
+    const double* values = reinterpret_cast< const double* >(payload);
+    std::vector< double > decoded;
+    std::uint64_t payloadHash = HashSeed;
+    if (ok && isLittleEndian()) {
+        // The payload is already in the host byte order and 8 byte aligned, so the mapping is used directly
+        for (std::size_t i = 0; i < numValues; i++) {
+            payloadHash = hashWord(payloadHash, doubleToBits(values[i]));
+        }
+    } else if (ok) {
+        decoded.resize(numValues);
+        for (std::size_t i = 0; i < numValues; i++) {
+            const std::uint64_t bits = readUint64(payload + i * 8);
+            decoded[i] = bitsToDouble(bits);
+            payloadHash = hashWord(payloadHash, bits);
+        }
+        values = decoded.data();
+    }
+    ok = ok && readUint64(buffer + 40) == payloadHash;
+
+    // Restore the orbits; every record has to be consumed completely
+    for (std::size_t i = 0; ok && i < numRecords; i++) {
+        const std::uint64_t begin = readUint64(buffer + HeaderSize + i * 8);
+        const std::uint64_t end = readUint64(buffer + HeaderSize + (i + 1) * 8);
+        if (begin >= end || end > numValues) {
+            ok = false;
+            break;
+        }
+
+        const double* state = values + begin;
+        orbits.push_back(new cOrbit(catalog.getTle(i), state));
+        ok = (state == values + end);
+    }
+
+    munmap(mapping, fileSize);
+    if (!ok) {
+        deleteOrbits(orbits);
+    }
+    return ok;
+}
@@ -0,0 +1,67 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_ElementCache_H__
+#define __OS3_ElementCache_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class cOrbit;
+class TLECatalog;
+
+//-----------------------------------------------------
+// Class: ElementCache
+// Binary cache of the initialized orbits of a TLE catalog. The cache stores the
+// recovered elements and the model constants (including the SDP4 deep space
+// initialization) of every satellite, so a later run restores the orbits without
+// initializing the orbit models again.
+//
+// File format (all values little endian):
+//   header:  magic "OS3ELEM\0", format version (uint32), reserved (uint32),
+//            hash and size of the TLE file (uint64 each), number of satellites (uint64),
+//            hash of the payload (uint64)
+//   offsets: number of satellites + 1 uint64 values (start of each record in the payload, in doubles)
+//   payload: the states written by cOrbit::saveState() as IEEE 754 doubles
+// A cache is only used if it was created from exactly the same TLE file content.
+//-----------------------------------------------------
+class ElementCache
+{
+public:
+    // Has to be incremented whenever the state layout of cOrbit or the Norad models changes
+    static const unsigned int Version;
+
+    /**
+     * Writes the cache of a catalog; the file is written to a temporary file first and renamed afterwards,
+     * so concurrent runs never read a partially written cache
+     * @param fileName Filename and path of the cache
+     * @param catalog Catalog the orbits were created from
+     * @param orbits Orbits of all satellites of the catalog
+     * @return false if the cache could not be written
+     */
+    static bool save(const std::string& fileName, const TLECatalog& catalog, const std::vector< cOrbit* >& orbits);
+
+    /**
+     * Memory-maps a cache and restores the orbits of all satellites of a catalog
+     * @param fileName Filename and path of the cache
+     * @param catalog Catalog the orbits are restored for
+     * @param orbits Output, orbits[k] is the orbit of satellite k (owned by the caller)
+     * @return false if the cache does not exist, is corrupted or does not match the catalog (orbits is left empty)
+     */
+    static bool load(const std::string& fileName, const TLECatalog& catalog, std::vector< cOrbit* >& orbits);
+};
+
+#endif
@@ -0,0 +1,233 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/EphemerisCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "os3/base/TLECatalog.h"
+
+const unsigned int EphemerisCache::Version = 2;
+
+namespace {
+
+const char Magic[8] = { 'O', 'S', '3', 'E', 'P', 'H', 'M', '\0' };
+const std::uint32_t ByteOrderMark = 0x01020304;
+
+// Tolerance of times on the grid (s); start times of different runs are converted to times since the
+// epoch with the precision of julian dates
+const double GridTolerance = 1e-3;
+
+// Header of a cache file; all fields are 8 byte aligned, so the samples directly follow it
+struct ephemerisHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint64_t tleHash;
+    double step;
+    double phase;
+    std::int64_t firstSample;
+    std::uint64_t numSamples;
+};
+
+}
+
+EphemerisCache::EphemerisCache()
+{
+    tleHash = 0;
+    step = 0;
+    phase = 0;
+    mapping = nullptr;
+    mappingSize = 0;
+    mapped = nullptr;
+    firstMapped = 0;
+    numMapped = 0;
+    firstRecorded = 0;
+}
+
+EphemerisCache::~EphemerisCache()
+{
+    close();
+}
+
+void EphemerisCache::close()
+{
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    mapped = nullptr;
+    firstMapped = 0;
+    numMapped = 0;
+    firstRecorded = 0;
+    recorded.clear();
+}
+
+void EphemerisCache::open(const std::string& directory, const std::uint64_t& tleHash, const double& step,
+                          const double& time)
+{
+    close();
+    this->tleHash = tleHash;
+    this->step = step;
+    phase = std::fmod(time, step);
+    if (phase < 0) {
+        phase += step;
+    }
+    if (phase >= step) {
+        phase = 0;
+    }
+
+    // The file name is derived from the format version, the element set and the step, the header identifies them exactly
+    std::uint64_t key = TLECatalog::hash(reinterpret_cast< const char* >(&Version), sizeof(Version), tleHash);
+    key = TLECatalog::hash(reinterpret_cast< const char* >(&step), sizeof(step), key);
+    char keyString[17];
+    std::snprintf(keyString, sizeof(keyString), "%016llx", static_cast< unsigned long long >(key));
+    fileName = directory + "/" + keyString + ".ephemeris";
+
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast< off_t >(sizeof(ephemerisHeader))) {
+        ::close(fd);
+        return;
+    }
+    const std::size_t fileSize = fileStat.st_size;
+    void* fileMapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (fileMapping == MAP_FAILED) {
+        return;
+    }
+
+    ephemerisHeader header;
+    std::memcpy(&header, fileMapping, sizeof(header));
+    const std::size_t numSamples = (fileSize - sizeof(header)) / (SampleSize * sizeof(double));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version
+            || header.byteOrderMark != ByteOrderMark || header.tleHash != tleHash
+            || header.step != step || header.numSamples != numSamples) {
+        munmap(fileMapping, fileSize);
+        return;
+    }
+
+    // Runs whose start times differ by a multiple of the step share the grid of the file (the phases are compared
+    // cyclically, as a phase close to 0 may be close to step in another run); other runs replace the file by save()
+    const double phaseDifference = std::fabs(header.phase - phase);
+    if (std::min(phaseDifference, step - phaseDifference) > GridTolerance) {
+        munmap(fileMapping, fileSize);
+        return;
+    }
+
+    phase = header.phase;
+    mapping = fileMapping;
+    mappingSize = fileSize;
+    mapped = reinterpret_cast< const double* >(static_cast< const char* >(fileMapping) + sizeof(header));
+    firstMapped = header.firstSample;
+    numMapped = numSamples;
+}
+
+bool EphemerisCache::getIndex(const double& time, std::int64_t& index) const
+{
+    const double offset = time - phase;
+    index = std::llround(offset / step);
+    return std::fabs(offset - index * step) <= GridTolerance;
+}
+
+const double* EphemerisCache::getSample(const std::int64_t& index) const
+{
+    if (index < firstMapped || index >= firstMapped + static_cast< std::int64_t >(numMapped)) {
+        return nullptr;
+    }
+    return mapped + (index - firstMapped) * SampleSize;
+}
+
+void EphemerisCache::addSample(const std::int64_t& index, const double* sample)
+{
+    if (recorded.empty()) {
+        firstRecorded = index;
+    }
+    const std::int64_t recordedEnd = firstRecorded + static_cast< std::int64_t >(getNumRecorded());
+    const std::int64_t mappedEnd = firstMapped + static_cast< std::int64_t >(numMapped);
+    if (index > recordedEnd && recordedEnd >= firstMapped && index <= mappedEnd) {
+        // The samples in between were cache hits; they are copied to keep the recorded range contiguous
+        const double* hits = getSample(recordedEnd);
+        recorded.insert(recorded.end(), hits, hits + (index - recordedEnd) * SampleSize);
+    }
+    else if (index != recordedEnd) {
+        return;
+    }
+    recorded.insert(recorded.end(), sample, sample + SampleSize);
+}
+
+bool EphemerisCache::save()
+{
+    if (fileName.empty() || recorded.empty()) {
+        return true;
+    }
+
+    // The mapped samples are kept if they overlap or adjoin the recorded ones
+    const std::int64_t recordedEnd = firstRecorded + static_cast< std::int64_t >(getNumRecorded());
+    const std::int64_t mappedEnd = firstMapped + static_cast< std::int64_t >(numMapped);
+    const bool merge = numMapped > 0 && firstRecorded <= mappedEnd && firstMapped <= recordedEnd;
+    const std::int64_t first = merge ? std::min(firstRecorded, firstMapped) : firstRecorded;
+    const std::int64_t end = merge ? std::max(recordedEnd, mappedEnd) : recordedEnd;
+
+    // Keep the file if it (e.g., written by a concurrent run) already holds at least as many samples
+    const std::size_t fileSize = sizeof(ephemerisHeader) + (end - first) * SampleSize * sizeof(double);
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat) == 0 && static_cast< std::size_t >(fileStat.st_size) >= fileSize) {
+        return true;
+    }
+
+    ephemerisHeader header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrderMark = ByteOrderMark;
+    header.tleHash = tleHash;
+    header.step = step;
+    header.phase = phase;
+    header.firstSample = first;
+    header.numSamples = end - first;
+
+    const std::string tempName = fileName + ".tmp" + std::to_string(static_cast< long >(getpid()));
+    std::ofstream fileStream(tempName.c_str(), std::ios::binary | std::ios::trunc);
+    fileStream.write(reinterpret_cast< const char* >(&header), sizeof(header));
+    if (first < firstRecorded) {
+        fileStream.write(reinterpret_cast< const char* >(getSample(first)),
+                         (firstRecorded - first) * SampleSize * sizeof(double));
+    }
+    fileStream.write(reinterpret_cast< const char* >(recorded.data()), recorded.size() * sizeof(double));
+    if (recordedEnd < end) {
+        fileStream.write(reinterpret_cast< const char* >(getSample(recordedEnd)),
+                         (end - recordedEnd) * SampleSize * sizeof(double));
+    }
+    fileStream.close();
+    if (!fileStream.good() || std::rename(tempName.c_str(), fileName.c_str()) != 0) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
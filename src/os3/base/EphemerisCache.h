@@ -0,0 +1,119 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_EphemerisCache_H__
+#define __OS3_EphemerisCache_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------
+// Class: EphemerisCache
+// Persistent cache of the ephemeris of one satellite on a fixed time grid. The grid
+// is absolute: sample k belongs to the time phase + k * step (seconds since the epoch
+// of the element set), so runs which start at other times (e.g., a minute later) share
+// the samples as long as their times lie on the same grid. The file is keyed on the
+// element set and the step only, so every satellite has one file per step.
+// Samples of earlier runs are memory-mapped and used instead of propagating the orbit
+// again. Samples which are not cached yet are recorded and merged into the file by
+// save(); the file is written to a temporary file and renamed, so concurrent runs
+// (e.g., of a parameter study) only ever see complete files and keep valid mappings of
+// older versions.
+//
+// File format (host byte order, files of other hosts are ignored):
+//   header:  magic "OS3EPHM\0", format version (uint32), byte order mark (uint32),
+//            TLE hash (uint64), step and phase (double each), index of the first
+//            sample (int64), number of samples (uint64)
+//   samples: SampleSize doubles per sample
+//-----------------------------------------------------
+class EphemerisCache
+{
+public:
+    // Has to be incremented whenever the content of a sample changes
+    static const unsigned int Version;
+
+    // Doubles per sample: ECI position (km), ECI velocity (km/s), latitude, longitude (rad) and altitude (km)
+    static const std::size_t SampleSize = 9;
+
+    EphemerisCache();
+    ~EphemerisCache();
+
+    /**
+     * Opens the cache of an ephemeris and maps the samples of earlier runs (if any)
+     * @param directory Directory of the cache files
+     * @param tleHash Hash of the element set of the satellite
+     * @param step Step of the time grid (s)
+     * @param time Any time on the grid of this run (s since the epoch of the element set)
+     */
+    void open(const std::string& directory, const std::uint64_t& tleHash, const double& step, const double& time);
+
+    /**
+     * Returns the index of a time on the grid
+     * @param time Time (s since the epoch of the element set)
+     * @param index Index of the sample of the time
+     * @return false if the time does not lie on the grid
+     */
+    bool getIndex(const double& time, std::int64_t& index) const;
+
+    /**
+     * Returns sample index
+     * @return Pointer to SampleSize doubles, nullptr if the sample is not cached
+     */
+    const double* getSample(const std::int64_t& index) const;
+
+    /**
+     * Records a computed sample; as the cache covers a contiguous range of the grid, only
+     * samples which extend the recorded range (possibly across mapped samples) are recorded
+     */
+    void addSample(const std::int64_t& index, const double* sample);
+
+    /**
+     * Writes the mapped and the recorded samples if samples were recorded; if both ranges
+     * are disjoint, the larger one is kept
+     * @return false if the file could not be written
+     */
+    bool save();
+
+    // Number of mapped samples and of recorded samples
+    std::size_t getNumMapped() const                       { return numMapped; }
+    std::size_t getNumRecorded() const                     { return recorded.size() / SampleSize; }
+
+    // File name of the cache
+    const std::string& getFileName() const                 { return fileName; }
+
+private:
+    // The mapping is owned by the cache
+    EphemerisCache(const EphemerisCache&);
+    EphemerisCache& operator=(const EphemerisCache&);
+
+    void close();
+
+    std::string fileName;
+    std::uint64_t tleHash;
+    double step;
+    double phase;                     // offset of the grid from the epoch, [0, step)
+
+    void* mapping;
+    std::size_t mappingSize;
+    const double* mapped;             // samples of earlier runs
+    std::int64_t firstMapped;         // index of the first mapped sample
+    std::size_t numMapped;
+    std::int64_t firstRecorded;       // index of the first recorded sample
+    std::vector< double > recorded;   // samples computed by this run
+};
+
+#endif
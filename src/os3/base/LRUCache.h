@@ -0,0 +1,208 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_LRUCache_H__
+#define __OS3_LRUCache_H__
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Hash function for coordinate pairs (latitude, longitude)
+ */
+struct coordinateHash
+{
+    std::size_t operator()(const std::pair< double, double >& key) const
+    {
+        const std::size_t h1 = std::hash< double >()(key.first);
+        const std::size_t h2 = std::hash< double >()(key.second);
+        return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+    }
+};
+
+//-----------------------------------------------------
+// Class: LRUCache
+// Cache with a fixed capacity and least-recently-used eviction. Lookups, insertions and
+// evictions are O(1): a hash map points into a list which is ordered by the last access.
+// Optionally, entries expire after a time-to-live. Expired entries are kept as a fallback
+// (see getStale()) until they are replaced or evicted. The cache does not read any clock
+// itself, the caller passes the current time (e.g., simulation or wall clock time in s).
+//-----------------------------------------------------
+template< typename Key, typename Value, typename Hash = std::hash< Key > >
+class LRUCache
+{
+public:
+    /**
+     * @param capacity Maximum number of entries, 0 disables the cache
+     * @param timeToLive Lifetime of an entry, 0 = entries do not expire
+     */
+    explicit LRUCache(std::size_t capacity = 0, double timeToLive = 0)
+        : maxEntries(capacity), ttl(timeToLive), numHits(0), numMisses(0), numEvictions(0), numExpirations(0)
+    {
+    }
+
+    /**
+     * Looks up an entry and marks it as most recently used
+     * @param key Key of the entry
+     * @param now Current time (same clock as used for put())
+     * @return Pointer to the cached value, nullptr if the entry does not exist or is expired.
+     *         The pointer is valid until the next modification of the cache.
+     */
+    const Value* get(const Key& key, const double& now)
+    {
+        typename IndexMap::iterator it = index.find(key);
+        if (it == index.end()) {
+            numMisses++;
+            return nullptr;
+        }
+        if (isExpired(*it->second, now)) {
+            // An entry expires once, although it may be looked up several times afterwards
+            if (!it->second->expirationCounted) {
+                it->second->expirationCounted = true;
+                numExpirations++;
+            }
+            numMisses++;
+            return nullptr;
+        }
+
+        // Move entry to the front (most recently used)
+        entries.splice(entries.begin(), entries, it->second);
+        numHits++;
+        return &it->second->value;
+    }
+
+    /**
+     * Looks up an entry regardless of its age (e.g., if fresh data can not be fetched) without changing
+     * the order or the statistics
+     * @return Pointer to the cached value, nullptr if the entry does not exist
+     */
+    const Value* getStale(const Key& key) const
+    {
+        typename IndexMap::const_iterator it = index.find(key);
+        return (it != index.end()) ? &it->second->value : nullptr;
+    }
+
+    /**
+     * Checks whether a valid entry exists without changing the order or the statistics
+     */
+    bool contains(const Key& key, const double& now) const
+    {
+        typename IndexMap::const_iterator it = index.find(key);
+        return it != index.end() && !isExpired(*it->second, now);
+    }
+
+    /**
+     * Inserts or replaces an entry; if the cache is full, the least recently used entry is evicted
+     * @param key Key of the entry
+     * @param value Value to store
+     * @param now Current time, the entry expires at now + timeToLive
+     */
+    void put(const Key& key, const Value& value, const double& now)
+    {
+        if (maxEntries == 0) {
+            return;
+        }
+
+        typename IndexMap::iterator it = index.find(key);
+        if (it != index.end()) {
+            it->second->value = value;
+            it->second->insertTime = now;
+            it->second->expirationCounted = false;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+
+        while (entries.size() >= maxEntries) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+            numEvictions++;
+        }
+
+        Entry entry;
+        entry.key = key;
+        entry.value = value;
+        entry.insertTime = now;
+        entry.expirationCounted = false;
+        entries.push_front(entry);
+        index[key] = entries.begin();
+    }
+
+    void erase(const Key& key)
+    {
+        typename IndexMap::iterator it = index.find(key);
+        if (it != index.end()) {
+            entries.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    void clear()
+    {
+        entries.clear();
+        index.clear();
+    }
+
+    // Changes the capacity; surplus entries are evicted
+    void setCapacity(const std::size_t& capacity)
+    {
+        maxEntries = capacity;
+        while (entries.size() > maxEntries) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+            numEvictions++;
+        }
+    }
+
+    void setTimeToLive(const double& timeToLive)                 { ttl = timeToLive; }
+
+    std::size_t size() const                                     { return entries.size(); }
+    std::size_t capacity() const                                 { return maxEntries; }
+    double timeToLive() const                                    { return ttl; }
+    unsigned long hits() const                                   { return numHits; }
+    unsigned long misses() const                                 { return numMisses; }
+    unsigned long evictions() const                              { return numEvictions; }
+    unsigned long expirations() const                            { return numExpirations; }  // entries found expired, each counted once
+
+private:
+    struct Entry
+    {
+        Key key;
+        Value value;
+        double insertTime;
+        bool expirationCounted;
+    };
+
+    typedef std::list< Entry > EntryList;
+    typedef std::unordered_map< Key, typename EntryList::iterator, Hash > IndexMap;
+
+    bool isExpired(const Entry& entry, const double& now) const
+    {
+        return ttl > 0 && now - entry.insertTime >= ttl;
+    }
+
+    EntryList entries;   // front = most recently used
+    IndexMap index;
+    std::size_t maxEntries;
+    double ttl;
+    unsigned long numHits;
+    unsigned long numMisses;
+    unsigned long numEvictions;
+    unsigned long numExpirations;
+};
+
+#endif
@@ -0,0 +1,290 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/LinkBudget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "os3/libnorad/cEci.h"
+#include "os3/libnorad/cSite.h"
+#include "os3/libnorad/globals.h"
+
+const double LinkBudget::C = 299792458;                    // In m/s;
+const double LinkBudget::Boltzmann = -228.6;               // In dBWs/K
+const double LinkBudget::EarthRadius = 6378.137764899274;  // In km
+
+bool RainTable::load(const std::string& fileName)
+{
+    // source: 'The aR^b Relation in the Calculation of Rain Attenuation', Olsen and Rogers and Hodge
+    std::ifstream fileStream(fileName.c_str());
+    if (!fileStream.good()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(fileStream, line)) {
+        // Ignore comments and empty lines
+        if (line.find("#") != std::string::npos || line.find(";") == std::string::npos) {
+            continue;
+        }
+
+        // Syntax: frequency;aLPl;aLPh;aMP;aJt;aJd;bLPl;bLPh;bMP;bJt;bJd
+        double values[11] = { 0 };
+        const char* field = line.c_str();
+        for (int i = 0; i < 11 && field != nullptr; i++) {
+            values[i] = std::atof(field);
+            field = std::strchr(field, ';');
+            if (field != nullptr) {
+                field++;
+            }
+        }
+
+        rainCoefficients newCoeff;
+        newCoeff.aLPl = values[1];
+        newCoeff.aLPh = values[2];
+        newCoeff.aMP = values[3];
+        newCoeff.aJt = values[4];
+        newCoeff.aJd = values[5];
+        newCoeff.bLPl = values[6];
+        newCoeff.bLPh = values[7];
+        newCoeff.bMP = values[8];
+        newCoeff.bJt = values[9];
+        newCoeff.bJd = values[10];
+
+        // Duplicate entries for a frequency overwrite older entries
+        coefficients[values[0]] = newCoeff;
+    }
+    return true;
+}
+
+double RainTable::getMappedFrequency(const double& frequency) const
+{
+    // Check if frequency already exists in map
+    if (coefficients.find(frequency) != coefficients.end()) {
+        return frequency;
+    }
+
+    double mindist(-1);
+    double freq(0.0);
+    std::map< double, rainCoefficients >::const_iterator it;
+    for (it = coefficients.begin(); it != coefficients.end(); it++) {
+        const double dist = std::abs(frequency - it->first); // Calculate euclidean distance
+        if (dist < mindist || mindist == -1) {
+            mindist = dist;
+            freq = it->first;
+        }
+    }
+    return freq;
+}
+
+const rainCoefficients* RainTable::getCoefficients(const double& lambda) const
+{
+    const double frequency = LinkBudget::C / lambda; // In Hz
+
+    // Map frequency on listed frequencies, table frequencies are given in GHz
+    std::map< double, rainCoefficients >::const_iterator it = coefficients.find(getMappedFrequency(frequency / 1e9));
+    if (it == coefficients.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+double LinkBudget::calcDistance(const double& latitude1, const double& longitude1,
+                                const double& latitude2, const double& longitude2)
+{
+    // Haversine formula: unlike the spherical law of cosines it does not lose precision for small distances
+    const double sinHalfDLat = std::sin(deg2rad(latitude2 - latitude1) / 2);
+    const double sinHalfDLon = std::sin(deg2rad(longitude2 - longitude1) / 2);
+    const double a = sinHalfDLat * sinHalfDLat +
+                     std::cos(deg2rad(latitude1)) * std::cos(deg2rad(latitude2)) * sinHalfDLon * sinHalfDLon;
+
+    return 2 * EarthRadius * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+unitVectors LinkBudget::calcUnitVectors(const std::vector< double >& latitudes, const std::vector< double >& longitudes)
+{
+    unitVectors vectors;
+    const std::size_t count = std::min(latitudes.size(), longitudes.size());
+    vectors.x.resize(count);
+    vectors.y.resize(count);
+    vectors.z.resize(count);
+
+    for (std::size_t i = 0; i < count; i++) {
+        const double lat = deg2rad(latitudes[i]);
+        const double lon = deg2rad(longitudes[i]);
+        vectors.x[i] = std::cos(lat) * std::cos(lon);
+        vectors.y[i] = std::cos(lat) * std::sin(lon);
+        vectors.z[i] = std::sin(lat);
+    }
+    return vectors;
+}
+
+void LinkBudget::calcDistancesFromVector(const double& x, const double& y, const double& z,
+                                         const unitVectors& targets, double* distances)
+{
+    const std::size_t count = targets.size();
+    const double* tx = targets.x.data();
+    const double* ty = targets.y.data();
+    const double* tz = targets.z.data();
+
+    // Chord length between the unit vectors (no trigonometric functions => vectorizable loop)
+    for (std::size_t j = 0; j < count; j++) {
+        const double dx = tx[j] - x;
+        const double dy = ty[j] - y;
+        const double dz = tz[j] - z;
+        distances[j] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    // Central angle = 2 * asin(chord / 2); equivalent to the haversine formula
+    for (std::size_t j = 0; j < count; j++) {
+        distances[j] = 2 * EarthRadius * std::asin(std::min(1.0, distances[j] / 2));
+    }
+}
+
+void LinkBudget::calcDistances(const double& latitude, const double& longitude, const unitVectors& stations,
+                               std::vector< double >& distances)
+{
+    const double lat = deg2rad(latitude);
+    const double lon = deg2rad(longitude);
+
+    distances.resize(stations.size());
+    calcDistancesFromVector(std::cos(lat) * std::cos(lon), std::cos(lat) * std::sin(lon), std::sin(lat),
+                            stations, distances.data());
+}
+
+void LinkBudget::calcDistances(const unitVectors& points, const unitVectors& stations, std::vector< double >& distances)
+{
+    const std::size_t stationCount = stations.size();
+    distances.resize(points.size() * stationCount);
+
+    for (std::size_t i = 0; i < points.size(); i++) {
+        calcDistancesFromVector(points.x[i], points.y[i], points.z[i], stations, &distances[i * stationCount]);
+    }
+}
+
+double LinkBudget::calcHorizonAngle(const double& satAltitude)
+{
+    return std::acos(EarthRadius / (EarthRadius + std::max(0.0, satAltitude)));
+}
+
+linkGeometry LinkBudget::calcLinkGeometry(const cEci& satellite, const double& latitude, const double& longitude,
+                                          const double& altitude, const double& precipPerHour)
+{
+    const cSite site(latitude, longitude, altitude);
+    const cCoordTopo topoLook = site.getLookAngle(satellite);
+
+    linkGeometry geometry;
+    geometry.satIndex = -1;
+    geometry.altitude = altitude;
+    geometry.elevation = rad2deg(topoLook.m_El);
+    geometry.distance = topoLook.m_Range;
+    geometry.precipPerHour = precipPerHour;
+    return geometry;
+}
+
+double LinkBudget::calcFSL(const double& distance, const double& lambda)
+{
+    return 20 * std::log10((4 * PI * distance) / (lambda / 1000)); // lambda in m <-> distance in km
+}
+
+double LinkBudget::calcRainAttenuation(const rainCoefficients& coefficients, const double& precipPerHour,
+                                       const double& elevation, const double& dR)
+{
+    const double a = coefficients.aMP;    // Coefficient a from table, using Marshall-Palmer distribution
+    const double b = coefficients.bMP;    // Coefficient b from table, using Marshall-Palmer distribution
+
+    const double le = dR / std::sin(deg2rad(elevation));      // Length of signal path through rain
+    const double gammaR = a * std::pow(precipPerHour, b);     // Specific attenuation depending on frequency and rain density
+    return gammaR * le;
+}
+
+double LinkBudget::calcSystemNoiseTemperature(const double& aRain, const double& dG, const double& tR)
+{
+    const double tB = 2.725;  // Cosmic microwave background in K +- 0.002K
+    const double tM = 270;    // Approximated atmospheric noise temperature in K
+    const double t0 = 290;    // Average temperature of earth surface in K
+
+    const double aRain_lin = std::pow(10, (aRain / 10));  // Transform aRain from dB to linear unit
+
+    // Noise temperature; source: 'Satellite Communications Systems', Maral et. Bousquet
+    const double tANoise = tB / aRain_lin + tM * (1 - 1 / aRain_lin) + t0 * dG;
+
+    return tANoise + tR;
+}
+
+double LinkBudget::calcCarrierPower(const linkGeometry& geometry, const carrierConfig& carrier,
+                                    const rainCoefficients& coefficients, const double& dR)
+{
+    const double aRain = calcRainAttenuation(coefficients, geometry.precipPerHour, geometry.elevation, dR);
+
+    return carrier.transmitterPower
+         + carrier.transmitterGain
+         + carrier.receiverGain
+         - aRain
+         - calcFSL(geometry.distance, carrier.lambda);
+}
+
+double LinkBudget::calcNoisePower(const linkGeometry& geometry, const carrierConfig& carrier,
+                                  const rainCoefficients& coefficients, const double& dG, const double& tR,
+                                  const double& dR)
+{
+    const double aRain = calcRainAttenuation(coefficients, geometry.precipPerHour, geometry.elevation, dR);
+    const double tSdB = 10 * std::log10(calcSystemNoiseTemperature(aRain, dG, tR));  // System noise temperature in dBK
+
+    return tSdB + Boltzmann + 10 * std::log10(carrier.bandwidth);
+}
+
+interferenceResult LinkBudget::calcInterference(const double& carrierPower, const double& noisePower,
+                                                const std::vector< double >& interferencePowers)
+{
+    // Interference powers add up linearly
+    double interferenceLin = 0;
+    for (std::size_t i = 0; i < interferencePowers.size(); i++) {
+        interferenceLin += std::pow(10, interferencePowers[i] / 10);
+    }
+    const double noiseLin = std::pow(10, noisePower / 10);
+
+    interferenceResult result;
+    result.snr = carrierPower - noisePower;
+    result.cir = (interferenceLin > 0) ? carrierPower - 10 * std::log10(interferenceLin)
+                                       : std::numeric_limits< double >::infinity();
+    result.cnir = carrierPower - 10 * std::log10(noiseLin + interferenceLin);
+    result.numInterferers = static_cast< int >(interferencePowers.size());
+    return result;
+}
+
+double LinkBudget::calcSNR(const linkGeometry& geometry, const carrierConfig& carrier,
+                           const rainCoefficients& coefficients, const double& dG, const double& tR,
+                           const double& dR)
+{
+    const double aRain = calcRainAttenuation(coefficients, geometry.precipPerHour, geometry.elevation, dR);
+    const double tSdB = 10 * std::log10(calcSystemNoiseTemperature(aRain, dG, tR));  // System noise temperature in dBK
+
+    const double snr = carrier.transmitterPower
+                     + carrier.transmitterGain
+                     + carrier.receiverGain
+                     - tSdB
+                     - aRain
+                     - calcFSL(geometry.distance, carrier.lambda)
+                     - Boltzmann
+                     - 10 * std::log10(carrier.bandwidth);
+
+    return snr;
+}
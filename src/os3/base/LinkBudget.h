@@ -0,0 +1,269 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_LinkBudget_H__
+#define __OS3_LinkBudget_H__
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+class cEci;
+
+/** Source: 'The aR^b Relation in the Calculation of Rain Attenuation', Olsen and Rogers and Hodge
+ * a and b are coefficients for different average dropsize distributions to calculate rain specific attenuation
+ * LPl: Laws and Parsons Distribution - low rain rate
+ * LPh: Laws and Parsons Distribution - high rain rate
+ * MP: Marshall-Palmer Distribution
+ * Jt: "Thunderstorm" Distribution
+ * Jd: "Drizzle" Distribution
+ */
+struct rainCoefficients
+{
+    double aLPl;
+    double aLPh;
+    double aMP;
+    double aJt;
+    double aJd;
+    double bLPl;
+    double bLPh;
+    double bMP;
+    double bJt;
+    double bJd;
+};
+
+/**
+ * Unit vectors of a set of points on the earth's surface (e.g., ground stations or sub-satellite points).
+ * The coordinates are stored as separate arrays (structure of arrays), such that the batch distance
+ * calculation runs as a plain loop over contiguous memory which the compiler can vectorize.
+ */
+struct unitVectors
+{
+    std::vector< double > x;
+    std::vector< double > y;
+    std::vector< double > z;
+
+    std::size_t size() const { return x.size(); }
+};
+
+/**
+ * Geometry and weather state of the link between a reference point and a satellite at one point in time.
+ * It does not depend on the carrier, so it is computed once and reused for any number of carrier configurations.
+ */
+struct linkGeometry
+{
+    int satIndex;          // Index of the satellite
+    double altitude;       // Altitude of the reference point
+    double elevation;      // Elevation of the satellite in degrees
+    double distance;       // Distance between reference point and satellite in km
+    double precipPerHour;  // Rain rate at the reference point in mm/h
+};
+
+/**
+ * Carrier dependent parameters of a link budget
+ */
+struct carrierConfig
+{
+    double transmitterGain;   // in dB
+    double receiverGain;      // in dB
+    double transmitterPower;  // in dBW
+    double lambda;            // Wave length in m
+    double bandwidth;         // in Hz
+};
+
+/**
+ * Result of an interference evaluation for one terminal
+ */
+struct interferenceResult
+{
+    double snr;          // C/N in dB (identical to calcSNR())
+    double cir;          // C/I in dB, +infinity if there is no interferer in view
+    double cnir;         // C/(N+I) in dB
+    int numInterferers;  // Number of co-channel satellites above the horizon that contributed to I
+};
+
+//-----------------------------------------------------
+// Class: RainTable
+// Table of rain attenuation coefficients per frequency.
+// The table is filled once by load() and only read afterwards, so a loaded table
+// can be shared between threads without locking.
+//-----------------------------------------------------
+class RainTable
+{
+public:
+    /**
+     * Loads the coefficients from a CSV file (default: data/TablespecRain.csv). Lines containing "#" are ignored,
+     * duplicate entries for a frequency overwrite older ones.
+     * @param fileName Filename and path of the table
+     * @return false if the file could not be opened
+     */
+    bool load(const std::string& fileName);
+
+    /**
+     * Maps the given frequency to a frequency existing in the table
+     * @param frequency Frequency of the used system in GHz
+     * @return Nearest frequency existing in the table, 0 if the table is empty
+     */
+    double getMappedFrequency(const double& frequency) const;
+
+    /**
+     * Returns the coefficients of the table entry nearest to the given wave length
+     * @param lambda Wave length in m
+     * @return Pointer to the coefficients, nullptr if the table is empty
+     */
+    const rainCoefficients* getCoefficients(const double& lambda) const;
+
+    bool empty() const                                     { return coefficients.empty(); }
+
+private:
+    // Frequency in GHz -> coefficients
+    std::map< double, rainCoefficients > coefficients;
+};
+
+//-----------------------------------------------------
+// Class: LinkBudget
+// Stateless link budget math (distances, path loss, rain attenuation, noise and SNR).
+// All methods are pure functions of their arguments: they neither depend on OMNeT++
+// nor on simulation modules and can be called concurrently from worker threads
+// or from offline analysis tools.
+//-----------------------------------------------------
+class LinkBudget
+{
+public:
+    static const double C;              // In m/s;
+    static const double Boltzmann;      // In dBWs/K
+    static const double EarthRadius;    // In km
+
+    /**
+     * Calculates the great-circle distance between two points (haversine formula)
+     * @return Distance in km
+     */
+    static double calcDistance(const double& latitude1, const double& longitude1,
+                               const double& latitude2, const double& longitude2);
+
+    /**
+     * Converts geographic coordinates (in degrees) into unit vectors
+     */
+    static unitVectors calcUnitVectors(const std::vector< double >& latitudes, const std::vector< double >& longitudes);
+
+    /**
+     * Calculates the distances in km from one unit vector to all given unit vectors
+     * (chord length converted to arc length, numerically stable for small distances)
+     * @param distances Output array, must hold at least targets.size() elements
+     */
+    static void calcDistancesFromVector(const double& x, const double& y, const double& z,
+                                        const unitVectors& targets, double* distances);
+
+    /**
+     * Calculates the great-circle distances in km between one point and N stations
+     */
+    static void calcDistances(const double& latitude, const double& longitude, const unitVectors& stations,
+                              std::vector< double >& distances);
+
+    /**
+     * Calculates the great-circle distances in km between N points and M stations (row-major N x M result)
+     */
+    static void calcDistances(const unitVectors& points, const unitVectors& stations, std::vector< double >& distances);
+
+    /**
+     * Calculates the earth central angle between the sub-satellite point and the horizon of a satellite,
+     * i.e., the half angle of the cone in which ground points see the satellite at elevation >= 0
+     * @param satAltitude Altitude of the satellite in km
+     * @return Central angle in radians
+     */
+    static double calcHorizonAngle(const double& satAltitude);
+
+    /**
+     * Calculates elevation and distance of a satellite as seen from a reference point
+     * @param satellite ECI position of the satellite (km based)
+     * @param latitude Latitude of the reference point in degrees
+     * @param longitude Longitude of the reference point in degrees
+     * @param altitude Altitude of the reference point
+     * @param precipPerHour Rain rate at the reference point in mm/h
+     * @return Link geometry (satIndex is set to -1)
+     */
+    static linkGeometry calcLinkGeometry(const cEci& satellite, const double& latitude, const double& longitude,
+                                         const double& altitude, const double& precipPerHour);
+
+    /**
+     * Calculates the free space loss
+     * @param distance Distance in km
+     * @param lambda Wave length in m
+     * @return Free space loss in dB
+     */
+    static double calcFSL(const double& distance, const double& lambda);
+
+    /**
+     * Calculates the rain attenuation along the slant path
+     * @param coefficients Rain coefficients for the used frequency (Marshall-Palmer distribution is used)
+     * @param precipPerHour Rain rate in mm/h
+     * @param elevation Elevation in degrees
+     * @param dR Highest point of rain area in km
+     * @return Rain attenuation in dB
+     */
+    static double calcRainAttenuation(const rainCoefficients& coefficients, const double& precipPerHour,
+                                      const double& elevation, const double& dR);
+
+    /**
+     * Calculates the system noise temperature; source: 'Satellite Communications Systems', Maral et. Bousquet
+     * @param aRain Rain attenuation in dB
+     * @param dG Average ratio of antenna radiation from ground
+     * @param tR Receiver noise temperature in K
+     * @return System noise temperature in K
+     */
+    static double calcSystemNoiseTemperature(const double& aRain, const double& dG, const double& tR);
+
+    /**
+     * Calculates the received carrier power
+     * @return Carrier power in dBW
+     */
+    static double calcCarrierPower(const linkGeometry& geometry, const carrierConfig& carrier,
+                                   const rainCoefficients& coefficients, const double& dR);
+
+    /**
+     * Calculates the noise power within the carrier bandwidth
+     * @return Noise power in dBW
+     */
+    static double calcNoisePower(const linkGeometry& geometry, const carrierConfig& carrier,
+                                 const rainCoefficients& coefficients, const double& dG, const double& tR,
+                                 const double& dR);
+
+    /**
+     * Combines carrier, noise and the sum of the interferer powers into C/N, C/I and C/(N+I)
+     * @param carrierPower Received carrier power in dBW
+     * @param noisePower Noise power in dBW
+     * @param interferencePowers Received powers of the interferers in dBW
+     * @return Interference result
+     */
+    static interferenceResult calcInterference(const double& carrierPower, const double& noisePower,
+                                               const std::vector< double >& interferencePowers);
+
+    /**
+     * Calculates the SNR for a transmission
+     * @param geometry Link geometry and weather state
+     * @param carrier Carrier configuration
+     * @param coefficients Rain coefficients for the carrier frequency
+     * @param dG Average ratio of antenna radiation from ground
+     * @param tR Receiver noise temperature in K
+     * @param dR Highest point of rain area in km
+     * @return SNR in dB
+     */
+    static double calcSNR(const linkGeometry& geometry, const carrierConfig& carrier,
+                          const rainCoefficients& coefficients, const double& dG, const double& tR,
+                          const double& dR);
+};
+
+#endif
@@ -0,0 +1,204 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/PrecipitationField.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const unsigned int PrecipitationField::Version = 1;
+
+namespace {
+
+const char Magic[8] = { 'O', 'S', '3', 'P', 'R', 'C', 'P', '\0' };
+const std::uint32_t ByteOrderMark = 0x01020304;
+
+// Header of a field file; all fields are 8 byte aligned, so the values directly follow it
+struct fieldHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint32_t numTimes;
+    std::uint32_t numLatitudes;
+    std::uint32_t numLongitudes;
+    std::uint32_t reserved;
+    double timeStart;
+    double timeStep;
+    double latitudeStart;
+    double latitudeStep;
+    double longitudeStart;
+    double longitudeStep;
+};
+
+}
+
+PrecipitationField::PrecipitationField()
+{
+    mapping = nullptr;
+    mappingSize = 0;
+    values = nullptr;
+    close();
+}
+
+PrecipitationField::~PrecipitationField()
+{
+    close();
+}
+
+void PrecipitationField::close()
+{
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    values = nullptr;
+    numTimes = 0;
+    numLatitudes = 0;
+    numLongitudes = 0;
+    timeStart = 0;
+    timeStep = 0;
+    latitudeStart = 0;
+    latitudeStep = 0;
+    longitudeStart = 0;
+    longitudeStep = 0;
+    globalLongitudes = false;
+}
+
+bool PrecipitationField::load(const std::string& fileName)
+{
+    close();
+
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast< off_t >(sizeof(fieldHeader))) {
+        ::close(fd);
+        return false;
+    }
+    const std::size_t fileSize = fileStat.st_size;
+    void* fileMapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (fileMapping == MAP_FAILED) {
+        return false;
+    }
+
+    fieldHeader header;
+    std::memcpy(&header, fileMapping, sizeof(header));
+    const std::size_t numValues = static_cast< std::size_t >(header.numTimes) * header.numLatitudes * header.numLongitudes;
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version
+            || header.byteOrderMark != ByteOrderMark || numValues == 0
+            || fileSize != sizeof(header) + numValues * sizeof(float)
+            || (header.numTimes > 1 && !(header.timeStep > 0))
+            || (header.numLatitudes > 1 && header.latitudeStep == 0)
+            || (header.numLongitudes > 1 && !(header.longitudeStep > 0))) {
+        munmap(fileMapping, fileSize);
+        return false;
+    }
+
+    mapping = fileMapping;
+    mappingSize = fileSize;
+    values = reinterpret_cast< const float* >(static_cast< const char* >(fileMapping) + sizeof(header));
+    numTimes = header.numTimes;
+    numLatitudes = header.numLatitudes;
+    numLongitudes = header.numLongitudes;
+    timeStart = header.timeStart;
+    timeStep = header.timeStep;
+    latitudeStart = header.latitudeStart;
+    latitudeStep = header.latitudeStep;
+    longitudeStart = header.longitudeStart;
+    longitudeStep = header.longitudeStep;
+    globalLongitudes = numLongitudes > 1 && numLongitudes * longitudeStep >= 360 - 1e-9;
+    return true;
+}
+
+void PrecipitationField::locate(const double& position, const std::size_t& size, std::size_t& lower,
+                                std::size_t& upper, double& weight)
+{
+    if (size < 2 || !(position > 0)) {
+        lower = upper = 0;
+        weight = 0;
+    } else if (position >= size - 1) {
+        lower = upper = size - 1;
+        weight = 0;
+    } else {
+        lower = static_cast< std::size_t >(position);
+        upper = lower + 1;
+        weight = position - lower;
+    }
+}
+
+double PrecipitationField::interpolate(const std::size_t& time, const std::size_t& lat0, const std::size_t& lat1,
+                                       const double& latWeight, const std::size_t& lon0, const std::size_t& lon1,
+                                       const double& lonWeight) const
+{
+    const float* raster = values + time * numLatitudes * numLongitudes;
+    const float corners[4] = { raster[lat0 * numLongitudes + lon0], raster[lat0 * numLongitudes + lon1],
+                               raster[lat1 * numLongitudes + lon0], raster[lat1 * numLongitudes + lon1] };
+
+    // Missing values (NaN) count as no rain
+    double value[4];
+    for (int i = 0; i < 4; i++) {
+        value[i] = std::isnan(corners[i]) ? 0 : corners[i];
+    }
+    return (1 - latWeight) * ((1 - lonWeight) * value[0] + lonWeight * value[1])
+            + latWeight * ((1 - lonWeight) * value[2] + lonWeight * value[3]);
+}
+
+double PrecipitationField::getPrecipPerHour(const double& latitude, const double& longitude, const double& time) const
+{
+    if (values == nullptr) {
+        return 0;
+    }
+
+    std::size_t lat0, lat1, time0, time1, lon0, lon1;
+    double latWeight, timeWeight, lonWeight;
+    locate((numLatitudes > 1) ? (latitude - latitudeStart) / latitudeStep : 0, numLatitudes, lat0, lat1, latWeight);
+    locate((numTimes > 1) ? (time - timeStart) / timeStep : 0, numTimes, time0, time1, timeWeight);
+
+    if (globalLongitudes) {
+        // The cell between the last and the first longitude closes the circle
+        double position = std::fmod(longitude - longitudeStart, 360.0) / longitudeStep;
+        if (position < 0) {
+            position += 360.0 / longitudeStep;
+        }
+        lon0 = static_cast< std::size_t >(position);
+        lonWeight = position - lon0;
+        if (lon0 >= numLongitudes) {
+            lon0 = numLongitudes - 1;
+            lonWeight = 0;
+        }
+        lon1 = (lon0 + 1) % numLongitudes;
+    } else {
+        locate((numLongitudes > 1) ? (longitude - longitudeStart) / longitudeStep : 0, numLongitudes, lon0, lon1,
+               lonWeight);
+    }
+
+    const double value0 = interpolate(time0, lat0, lat1, latWeight, lon0, lon1, lonWeight);
+    if (timeWeight == 0) {
+        return value0;
+    }
+    const double value1 = interpolate(time1, lat0, lat1, latWeight, lon0, lon1, lonWeight);
+    return (1 - timeWeight) * value0 + timeWeight * value1;
+}
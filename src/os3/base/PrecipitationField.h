@@ -0,0 +1,97 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_PrecipitationField_H__
+#define __OS3_PrecipitationField_H__
+
+#include <cstddef>
+#include <string>
+
+//-----------------------------------------------------
+// Class: PrecipitationField
+// Gridded rain rate field (a time series of latitude/longitude rasters, e.g., converted
+// from a radar composite or a reanalysis dataset). The file is memory-mapped, so only
+// the pages of the queried regions are read, and a query interpolates bilinearly in
+// space and linearly in time between eight grid values, independent of the size of
+// the field and without network access.
+//
+// File format (host byte order, checked by the byte order mark):
+//   header:  magic "OS3PRCP\0", format version (uint32), byte order mark 0x01020304 (uint32),
+//            number of times, latitudes and longitudes (uint32 each), reserved (uint32, 0),
+//            time start and step in s of simulation time (double each),
+//            latitude start and step, longitude start and step in degrees (double each)
+//   values:  rain rate in mm/h (float) as [time][latitude][longitude], NaN = no data (no rain)
+//-----------------------------------------------------
+class PrecipitationField
+{
+public:
+    static const unsigned int Version;
+
+    PrecipitationField();
+    ~PrecipitationField();
+
+    /**
+     * Maps and checks a field file
+     * @param fileName Filename and path of the field
+     * @return false if the file can not be opened or is not a valid field
+     */
+    bool load(const std::string& fileName);
+
+    /**
+     * Returns the rain rate at a location and time. Locations outside of the grid get the value of the nearest
+     * grid border (longitudes wrap around for global grids), times outside of the series that of the first or last raster.
+     * @param latitude Latitude in degrees
+     * @param longitude Longitude in degrees
+     * @param time Simulation time in s
+     * @return Rain rate in mm/h
+     */
+    double getPrecipPerHour(const double& latitude, const double& longitude, const double& time) const;
+
+    bool isLoaded() const                                  { return values != nullptr; }
+    std::size_t getNumTimes() const                        { return numTimes; }
+    std::size_t getNumLatitudes() const                    { return numLatitudes; }
+    std::size_t getNumLongitudes() const                   { return numLongitudes; }
+
+private:
+    // The mapping is owned by the field
+    PrecipitationField(const PrecipitationField&);
+    PrecipitationField& operator=(const PrecipitationField&);
+
+    void close();
+
+    // Bilinear interpolation within the raster of time index time
+    double interpolate(const std::size_t& time, const std::size_t& lat0, const std::size_t& lat1, const double& latWeight,
+                       const std::size_t& lon0, const std::size_t& lon1, const double& lonWeight) const;
+
+    // Maps a coordinate onto the neighbouring grid indices and the weight of the upper one
+    static void locate(const double& position, const std::size_t& size, std::size_t& lower, std::size_t& upper,
+                       double& weight);
+
+    void* mapping;
+    std::size_t mappingSize;
+    const float* values;
+    std::size_t numTimes;
+    std::size_t numLatitudes;
+    std::size_t numLongitudes;
+    double timeStart;
+    double timeStep;
+    double latitudeStart;
+    double latitudeStep;
+    double longitudeStart;
+    double longitudeStep;
+    bool globalLongitudes;                // the longitudes cover 360 degrees and wrap around
+};
+
+#endif
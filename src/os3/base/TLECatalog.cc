@@ -0,0 +1,315 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/TLECatalog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "os3/libnorad/cOrbit.h"
+#include "os3/libnorad/cTLE.h"
+
+TLECatalog::TLECatalog() :
+    data(nullptr), dataSize(0), mapping(nullptr), mappingSize(0), numInvalid(0)
+{
+}
+
+TLECatalog::~TLECatalog()
+{
+    clear();
+}
+
+void TLECatalog::clear()
+{
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+    ownedText.clear();
+    data = nullptr;
+    dataSize = 0;
+
+    lines.clear();
+    nameIndex.clear();
+    numberIndex.clear();
+    valid.clear();
+    numInvalid = 0;
+}
+
+void TLECatalog::parse(const std::string& text)
+{
+    clear();
+    ownedText = text;
+    data = ownedText.data();
+    dataSize = ownedText.size();
+    buildIndex();
+}
+
+bool TLECatalog::load(const std::string& fileName)
+{
+    clear();
+
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        void* mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, fileStat.st_size, MADV_SEQUENTIAL);
+            mapping = mapped;
+            mappingSize = fileStat.st_size;
+            data = static_cast< const char* >(mapped);
+            dataSize = mappingSize;
+        }
+    }
+    close(fd);
+
+    // Fall back to reading the file (e.g., empty files or file systems without mmap support)
+    if (mapping == nullptr) {
+        std::ifstream fileStream(fileName.c_str(), std::ios::in | std::ios::binary);
+        if (!fileStream.good()) {
+            return false;
+        }
+        std::ostringstream content;
+        content << fileStream.rdbuf();
+        ownedText = content.str();
+        data = ownedText.data();
+        dataSize = ownedText.size();
+    }
+
+    buildIndex();
+    return true;
+}
+
+void TLECatalog::buildIndex()
+{
+    // Single pass over the buffer: record the position of every non-blank line (TLE lines have 69 characters)
+    lines.reserve(dataSize / 50);
+    std::size_t start = 0;
+    while (start < dataSize) {
+        const char* newline = static_cast< const char* >(std::memchr(data + start, '\n', dataSize - start));
+        const std::size_t end = (newline != nullptr) ? static_cast< std::size_t >(newline - data) : dataSize;
+
+        std::size_t length = end - start;
+        if (length > 0 && data[start + length - 1] == '\r') {
+            length--;
+        }
+        if (length > 0) {
+            lineSpan span;
+            span.offset = start;
+            span.length = length;
+            lines.push_back(span);
+        }
+        start = end + 1;
+    }
+
+    // Incomplete records at the end are dropped
+    lines.resize(lines.size() - lines.size() % 3);
+
+    // Index names (without padding blanks) and catalog numbers; the first occurrence wins
+    valid.resize(size());
+    for (std::size_t i = 0; i < size(); i++) {
+        const lineSpan& span = lines[i * 3];
+        std::size_t length = span.length;
+        while (length > 0 && (data[span.offset + length - 1] == ' ' || data[span.offset + length - 1] == '\t')) {
+            length--;
+        }
+        nameIndex.insert(std::make_pair(std::string(data + span.offset, length), i));
+
+        const lineSpan& line1 = lines[i * 3 + 1];
+        const lineSpan& line2 = lines[i * 3 + 2];
+        if (line1.length >= 7) {
+            numberIndex.insert(std::make_pair(std::strtol(std::string(data + line1.offset + 2, 5).c_str(), nullptr, 10), i));
+        }
+
+        valid[i] = verifyChecksum(data + line1.offset, line1.length) && verifyChecksum(data + line2.offset, line2.length);
+        if (!valid[i]) {
+            numInvalid++;
+        }
+    }
+}
+
+bool TLECatalog::verifyChecksum(const char* line, const std::size_t& length)
+{
+    if (length < 69 || line[68] < '0' || line[68] > '9') {
+        return false;
+    }
+
+    int checksum = 0;
+    for (std::size_t i = 0; i < 68; i++) {
+        if (line[i] >= '0' && line[i] <= '9') {
+            checksum += line[i] - '0';
+        } else if (line[i] == '-') {
+            checksum++;
+        }
+    }
+    return checksum % 10 == line[68] - '0';
+}
+
+long TLECatalog::find(const std::string& name) const
+{
+    std::unordered_map< std::string, std::size_t >::const_iterator it = nameIndex.find(name);
+    if (it != nameIndex.end()) {
+        return static_cast< long >(it->second);
+    }
+
+    // No exact match => first satellite whose name contains name
+    for (std::size_t i = 0; i < size(); i++) {
+        const char* first = data + lines[i * 3].offset;
+        const char* last = first + lines[i * 3].length;
+        if (std::search(first, last, name.begin(), name.end()) != last) {
+            return static_cast< long >(i);
+        }
+    }
+    return -1;
+}
+
+cTle TLECatalog::getTle(const std::size_t& index) const
+{
+    std::string name = getName(index);
+    name = name.substr(0, name.find("  "));
+    std::string line1 = getLine1(index);
+    std::string line2 = getLine2(index);
+    return cTle(name, line1, line2);
+}
+
+std::uint64_t TLECatalog::getContentHash() const
+{
+    return hash(data, dataSize);
+}
+
+std::uint64_t TLECatalog::hash(const char* buffer, const std::size_t& size, std::uint64_t seed)
+{
+    for (std::size_t i = 0; i < size; i++) {
+        seed ^= static_cast< unsigned char >(buffer[i]);
+        seed *= 1099511628211ULL;
+    }
+    return seed;
+}
+
+long TLECatalog::findByCatalogNumber(const long& catalogNumber) const
+{
+    std::unordered_map< long, std::size_t >::const_iterator it = numberIndex.find(catalogNumber);
+    return (it != numberIndex.end()) ? static_cast< long >(it->second) : -1;
+}
+
+long TLECatalog::getCatalogNumber(const std::size_t& index) const
+{
+    if (index >= size() || lines[index * 3 + 1].length < 7) {
+        return -1;
+    }
+    return std::strtol(std::string(data + lines[index * 3 + 1].offset + 2, 5).c_str(), nullptr, 10);
+}
+
+void TLECatalog::diff(const TLECatalog& previous, std::vector< std::size_t >& changed) const
+{
+    changed.clear();
+    for (std::size_t i = 0; i < size(); i++) {
+        const long previousIndex = previous.findByCatalogNumber(getCatalogNumber(i));
+        if (previousIndex < 0 || !equalLines(i * 3 + 1, previous, previousIndex * 3 + 1)
+                || !equalLines(i * 3 + 2, previous, previousIndex * 3 + 2)) {
+            changed.push_back(i);
+        }
+    }
+}
+
+bool TLECatalog::equalLines(const std::size_t& line, const TLECatalog& other, const std::size_t& otherLine) const
+{
+    const lineSpan& span = lines[line];
+    const lineSpan& otherSpan = other.lines[otherLine];
+    return span.length == otherSpan.length
+            && std::memcmp(data + span.offset, other.data + otherSpan.offset, span.length) == 0;
+}
+
+std::string TLECatalog::getLine(const std::size_t& line) const
+{
+    if (line >= lines.size()) {
+        return std::string();
+    }
+    return std::string(data + lines[line].offset, lines[line].length);
+}
+
+void TLECatalog::createOrbits(std::vector< cOrbit* >& orbits, unsigned int numThreads) const
+{
+    orbits.assign(size(), nullptr);
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Satellites are handed out in small chunks, because SGP4 and SDP4 orbits differ a lot in construction time
+    const std::size_t chunkSize = 64;
+    std::atomic< std::size_t > nextChunk(0);
+    const TLECatalog* catalog = this;
+
+    // The first exception of a worker (e.g., from a malformed element set) stops all workers and is rethrown
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+
+    auto worker = [&orbits, &nextChunk, &failureMutex, &failure, catalog, chunkSize]() {
+        const std::size_t count = catalog->size();
+        try {
+            for (;;) {
+                const std::size_t first = nextChunk.fetch_add(chunkSize);
+                if (first >= count) {
+                    break;
+                }
+                const std::size_t last = std::min(count, first + chunkSize);
+                for (std::size_t i = first; i < last; i++) {
+                    orbits[i] = new cOrbit(catalog->getTle(i));
+                }
+            }
+        } catch (...) {
+            std::lock_guard< std::mutex > lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            nextChunk = count;
+        }
+    };
+
+    std::vector< std::thread > threads;
+    const std::size_t numWorkers = std::min< std::size_t >(numThreads, (size() + chunkSize - 1) / chunkSize);
+    for (std::size_t t = 1; t < numWorkers; t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (std::size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    if (failure) {
+        for (std::size_t i = 0; i < orbits.size(); i++) {
+            delete orbits[i];
+        }
+        orbits.clear();
+        std::rethrow_exception(failure);
+    }
+}
@@ -0,0 +1,162 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_TLECatalog_H__
+#define __OS3_TLECatalog_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class cOrbit;
+class cTle;
+
+//-----------------------------------------------------
+// Class: TLECatalog
+// Catalog of two-line element sets (three lines per satellite: name, line 1, line 2).
+// The text is kept in one buffer (a memory mapping of the file if possible) and scanned
+// exactly once; records are stored as line offsets into that buffer, so accessing
+// satellite k is O(1) and strings are only created for the records which are actually
+// requested.
+//-----------------------------------------------------
+class TLECatalog
+{
+public:
+    TLECatalog();
+    ~TLECatalog();
+
+    /**
+     * Indexes the given text (the text is copied); blank lines are ignored and trailing '\r' are removed
+     * @param text Content of a TLE file
+     */
+    void parse(const std::string& text);
+
+    /**
+     * Memory-maps and indexes a TLE file (falls back to reading the file if it can not be mapped)
+     * @param fileName Filename and path of the TLE file
+     * @return false if the file could not be opened
+     */
+    bool load(const std::string& fileName);
+
+    // Number of satellites in the catalog
+    std::size_t size() const                               { return lines.size() / 3; }
+    bool empty() const                                     { return lines.empty(); }
+
+    // Returns the name line (including padding blanks), TLE line 1 or TLE line 2 of satellite index
+    std::string getName(const std::size_t& index) const    { return getLine(index * 3); }
+    std::string getLine1(const std::size_t& index) const   { return getLine(index * 3 + 1); }
+    std::string getLine2(const std::size_t& index) const   { return getLine(index * 3 + 2); }
+
+    /**
+     * Returns the element set of a satellite (the name is shortened at the first double blank, as done by Norad)
+     */
+    cTle getTle(const std::size_t& index) const;
+
+    // Hash of the complete file content (identifies the file version, e.g., for caches)
+    std::uint64_t getContentHash() const;
+
+    // Size of the file content in bytes
+    std::size_t getContentSize() const                     { return dataSize; }
+
+    // 64 bit FNV-1a hash of a buffer
+    static std::uint64_t hash(const char* buffer, const std::size_t& size, std::uint64_t seed = 14695981039346656037ULL);
+
+    /**
+     * Verifies the checksums of both TLE lines of a satellite
+     * @return false if a checksum does not match or a line is too short
+     */
+    bool isValid(const std::size_t& index) const           { return index < valid.size() && valid[index]; }
+
+    // Number of satellites with invalid checksums
+    std::size_t getNumInvalid() const                      { return numInvalid; }
+
+    /**
+     * Verifies the modulo 10 checksum in column 69 of a TLE line (digits count with their value, '-' counts 1)
+     */
+    static bool verifyChecksum(const char* line, const std::size_t& length);
+
+    /**
+     * Finds a satellite by name. Names are compared without their padding blanks; if there is no exact match,
+     * the first satellite whose name contains name is returned.
+     * @return Index of the satellite, -1 if it does not exist
+     */
+    long find(const std::string& name) const;
+
+    /**
+     * Finds a satellite by its NORAD catalog number (columns 3-7 of TLE line 1)
+     * @return Index of the satellite, -1 if it does not exist
+     */
+    long findByCatalogNumber(const long& catalogNumber) const;
+
+    // NORAD catalog number of a satellite (columns 3-7 of TLE line 1), -1 if line 1 is too short
+    long getCatalogNumber(const std::size_t& index) const;
+
+    /**
+     * Compares the element sets (TLE lines 1 and 2) with an earlier version of the catalog; satellites are
+     * matched by their catalog number
+     * @param previous Earlier version of the catalog
+     * @param changed Output, indices of the satellites which are new or whose element set differs
+     */
+    void diff(const TLECatalog& previous, std::vector< std::size_t >& changed) const;
+
+    /**
+     * Constructs the orbits of all satellites in parallel. This includes parsing the elements and the
+     * model initialization (e.g., the SDP4 deep space initialization), which dominates the ingest time of
+     * large catalogs.
+     * @param orbits Output, orbits[k] is the orbit of satellite k (owned by the caller)
+     * @param numThreads Number of worker threads, 0 = number of cores
+     * @throws The first exception of an orbit construction, after all workers have finished (orbits is then empty)
+     */
+    void createOrbits(std::vector< cOrbit* >& orbits, unsigned int numThreads = 0) const;
+
+private:
+    // Position of one line within the text buffer
+    struct lineSpan
+    {
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    // The buffer may be a memory mapping, so catalogs are not copyable
+    TLECatalog(const TLECatalog&);
+    TLECatalog& operator=(const TLECatalog&);
+
+    // Releases the buffer and the index
+    void clear();
+
+    // Scans the buffer and builds the index
+    void buildIndex();
+
+    std::string getLine(const std::size_t& line) const;
+
+    // Compares line of this catalog with otherLine of other without creating strings
+    bool equalLines(const std::size_t& line, const TLECatalog& other, const std::size_t& otherLine) const;
+
+    const char* data;                                           // text buffer (ownedText or mapping)
+    std::size_t dataSize;
+    std::string ownedText;
+    void* mapping;
+    std::size_t mappingSize;
+
+    std::vector< lineSpan > lines;                              // three lines per satellite
+    std::unordered_map< std::string, std::size_t > nameIndex;   // trimmed name -> satellite index
+    std::unordered_map< long, std::size_t > numberIndex;        // NORAD catalog number -> satellite index
+    std::vector< bool > valid;                                  // checksums of both lines are correct
+    std::size_t numInvalid;
+};
+
+#endif
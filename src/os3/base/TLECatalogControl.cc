@@ -0,0 +1,136 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#include "os3/base/TLECatalogControl.h"
+
+#include <chrono>
+#include <exception>
+
+#include "os3/base/ElementCache.h"
+#include "os3/libnorad/cOrbit.h"
+
+Define_Module(TLECatalogControl);
+
+void TLECatalogControl::initialize()
+{
+    validateChecksums = par("validateChecksums");
+    prebuildOrbits = par("prebuildOrbits");
+    numThreads = par("numThreads");
+    elementCacheDir = par("elementCacheDir").stdstringValue();
+    elementCacheHits = 0;
+    ingestTime = 0;
+}
+
+void TLECatalogControl::handleMessage(cMessage* msg)
+{
+    error("Error in TLECatalogControl::handleMessage(): This module is not able to handle messages.");
+}
+
+void TLECatalogControl::finish()
+{
+    std::size_t numRecords = 0;
+    std::size_t numInvalid = 0;
+    std::map< std::string, TLECatalog >::const_iterator it;
+    for (it = catalogs.begin(); it != catalogs.end(); it++) {
+        numRecords += it->second.size();
+        numInvalid += it->second.getNumInvalid();
+    }
+
+    recordScalar("tleFilesLoaded", catalogs.size());
+    recordScalar("tleRecordsLoaded", numRecords);
+    recordScalar("tleChecksumErrors", numInvalid);
+    if (!elementCacheDir.empty()) {
+        recordScalar("elementCacheHits", elementCacheHits);
+    }
+    if (ingestTime > 0) {
+        recordScalar("tleIngestRecordsPerSecond", numRecords / ingestTime);
+    }
+
+    // Delete prebuilt orbits which were not taken by a Norad module
+    std::map< std::string, std::vector< cOrbit* > >::iterator orbitIt;
+    for (orbitIt = orbits.begin(); orbitIt != orbits.end(); orbitIt++) {
+        for (std::size_t i = 0; i < orbitIt->second.size(); i++) {
+            delete orbitIt->second[i];
+        }
+    }
+    orbits.clear();
+}
+
+cOrbit* TLECatalogControl::takeOrbit(const std::string& fileName, const std::size_t& index)
+{
+    std::map< std::string, std::vector< cOrbit* > >::iterator it = orbits.find(fileName);
+    if (it == orbits.end() || index >= it->second.size()) {
+        return nullptr;
+    }
+
+    cOrbit* orbit = it->second[index];
+    it->second[index] = nullptr;
+    return orbit;
+}
+
+const TLECatalog& TLECatalogControl::getCatalog(const std::string& fileName)
+{
+    std::map< std::string, TLECatalog >::iterator it = catalogs.find(fileName);
+    if (it != catalogs.end()) {
+        return it->second;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    TLECatalog& catalog = catalogs[fileName];
+    if (!catalog.load(fileName)) {
+        error("Error in TLECatalogControl::getCatalog(): Could not open TLE file \"%s\".", fileName.c_str());
+    }
+    if (!elementCacheDir.empty()) {
+        // The cache is named after the TLE file; a cache of another version of the file is rebuilt
+        const std::string baseName = fileName.substr(fileName.find_last_of("/\\") + 1);
+        const std::string cacheName = elementCacheDir + "/" + baseName + ".elements";
+        if (ElementCache::load(cacheName, catalog, orbits[fileName])) {
+            elementCacheHits++;
+        } else {
+            createOrbits(catalog, fileName);
+            if (!ElementCache::save(cacheName, catalog, orbits[fileName])) {
+                EV << "Warning in TLECatalogControl::getCatalog(): Could not write element cache " << cacheName
+                   << "." << std::endl;
+            }
+        }
+    } else if (prebuildOrbits) {
+        createOrbits(catalog, fileName);
+    }
+
+    const double duration = std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count();
+    ingestTime += duration;
+    if (catalog.getNumInvalid() > 0) {
+        EV << "Warning in TLECatalogControl::getCatalog(): " << catalog.getNumInvalid() << " of " << catalog.size()
+           << " satellites in " << fileName << " have invalid checksums." << std::endl;
+    }
+
+    EV << "TLECatalogControl: loaded " << catalog.size() << " satellites from " << fileName << " in " << duration
+       << " s (" << (duration > 0 ? catalog.size() / duration : 0) << " records/s)" << std::endl;
+    return catalog;
+}
+
+void TLECatalogControl::createOrbits(const TLECatalog& catalog, const std::string& fileName)
+{
+    try {
+        catalog.createOrbits(orbits[fileName], numThreads);
+    } catch (const std::exception& e) {
+        error("Error in TLECatalogControl::createOrbits(): Could not initialize the orbits of \"%s\": %s",
+              fileName.c_str(), e.what());
+    } catch (...) {
+        error("Error in TLECatalogControl::createOrbits(): Could not initialize the orbits of \"%s\".",
+              fileName.c_str());
+    }
+}
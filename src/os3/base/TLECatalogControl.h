@@ -0,0 +1,76 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef __OS3_TLECatalogControl_H__
+#define __OS3_TLECatalogControl_H__
+
+#include <omnetpp.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "os3/base/TLECatalog.h"
+
+class cOrbit;
+
+//-----------------------------------------------------
+// Class: TLECatalogControl
+// Loads every TLE file once and shares the indexed catalog with all Norad modules,
+// so that looking up the element set of a satellite does not rescan the file.
+//-----------------------------------------------------
+class TLECatalogControl : public cSimpleModule
+{
+public:
+    /**
+     * Returns the catalog of a TLE file; the file is loaded, indexed and checked on first use
+     * @param fileName Filename and path of the TLE file
+     * @return Indexed catalog (valid until the end of the simulation)
+     */
+    const TLECatalog& getCatalog(const std::string& fileName);
+
+    /**
+     * Hands over the prebuilt orbit of a satellite (see parameter prebuildOrbits); every orbit can be taken only once
+     * @param fileName Filename and path of the TLE file
+     * @param index Index of the satellite in the file
+     * @return Orbit (owned by the caller), nullptr if it was not prebuilt or already taken
+     */
+    cOrbit* takeOrbit(const std::string& fileName, const std::size_t& index);
+
+    // Whether satellites with invalid checksums must not be used
+    bool getValidateChecksums() const                      { return validateChecksums; }
+
+protected:
+    virtual void initialize();
+
+    virtual void handleMessage(cMessage* msg);
+
+    virtual void finish();
+
+    // Constructs the orbits of all satellites of catalog in parallel, failures are reported by error()
+    void createOrbits(const TLECatalog& catalog, const std::string& fileName);
+
+private:
+    bool validateChecksums;
+    bool prebuildOrbits;
+    unsigned int numThreads;
+    std::string elementCacheDir;
+    unsigned int elementCacheHits;
+    std::map< std::string, TLECatalog > catalogs;             // file name -> catalog
+    std::map< std::string, std::vector< cOrbit* > > orbits;   // file name -> prebuilt orbits (not yet taken)
+    double ingestTime;                                        // wall clock time for loading and orbit construction in s
+};
+
+#endif
@@ -29,6 +29,17 @@ void WeatherControl::initialize()
 
     // Initialize default precipPerHourValue (-1 = not set)
     defaultPrecipPerHour = par("defaultPrecipPerHour");
+
+    // Load the gridded precipitation field if one is configured
+    const std::string fieldFile = par("precipitationField").stringValue();
+    if (fieldFile != "") {
+        if (!precipitationField.load(fieldFile)) {
+            error("Error in WeatherControl::initialize(): Could not load precipitation field \"%s\".", fieldFile.c_str());
+        }
+        EV << "WeatherControl: precipitation field with " << precipitationField.getNumTimes() << " rasters of "
+           << precipitationField.getNumLatitudes() << " x " << precipitationField.getNumLongitudes() << " points"
+           << std::endl;
+    }
 }
 
 void WeatherControl::handleMessage(cMessage* msg)
@@ -39,7 +50,12 @@ void WeatherControl::handleMessage(cMessage* msg)
 void WeatherControl::setWeatherGimmick(const double& latitude, const double& longitude)
 {
     // Fetch symbol fitting current weather situation
-    std::string tmpString = webServiceControl->getWeatherData(latitude, longitude).weatherIconURL;
+    setWeatherGimmick(webServiceControl->getWeatherData(latitude, longitude));
+}
+
+void WeatherControl::setWeatherGimmick(const WeatherData& weatherData)
+{
+    std::string tmpString = weatherData.weatherIconURL;
 
     // Modify weatherIconURl: Erase URL from string and add weaterIcons folder before file name
     if (tmpString.find("wsymbol") == tmpString.npos) {
@@ -73,11 +89,16 @@ double WeatherControl::getPrecipPerHour(const double& latitude, const double& lo
         return defaultPrecipPerHour;
     }
 
-    // Get weather data
+    // The local field is answered without any web request
+    if (precipitationField.isLoaded()) {
+        return precipitationField.getPrecipPerHour(latitude, longitude, simTime().dbl());
+    }
+
+    // Get weather data (fetched once and used for the precipitation and the weather icon)
     WeatherData currentData = webServiceControl->getWeatherData(latitude, longitude);
 
     // Set weather icon
-    setWeatherGimmick(latitude, longitude);
+    setWeatherGimmick(currentData);
 
     return currentData.precipMM / 24; //transform precip per day to precip per hour
 }
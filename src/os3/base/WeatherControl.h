@@ -18,11 +18,15 @@
 
 #include <omnetpp.h>
 
+#include "os3/base/PrecipitationField.h"
+
 class WebServiceControl;
+struct WeatherData;
 
 //-----------------------------------------------------
 // Class: WeatherControl
 // This class gets weather information from web service and integrates them in the simulation.
+// Alternatively, the precipitation is taken from a local gridded rain rate field (see PrecipitationField).
 //-----------------------------------------------------
 class WeatherControl : public cSimpleModule
 {
@@ -41,8 +45,9 @@ public:
     /**
      * @brief Gets the current (live!) precipation per hour
      * This method gets the current precipation (=rainfall) per hour value.
-     * If a default value is NOT set (defaultPrecipPerHour = -1), it fetches live (!) weather data from the
-     * Web service module. Does not update the weatherGimmick.
+     * If a default value is NOT set (defaultPrecipPerHour = -1), it interpolates the precipitation field at the current
+     * simulation time (if a field is configured) or fetches live (!) weather data from the Web service module.
+     * Does not update the weatherGimmick.
      * @param latitude Coordinate for the reference point
      * @param longitude Coordinate for the reference point
      * @return Current precipation in mm/(m²*h)
@@ -61,9 +66,13 @@ protected:
 
     virtual void handleMessage(cMessage* msg);
 
+    // Sets the weather symbol from already fetched weather data
+    void setWeatherGimmick(const WeatherData& weatherData);
+
 private:
     WebServiceControl* webServiceControl;
     double defaultPrecipPerHour;
+    PrecipitationField precipitationField;
 };
 
 #endif
@@ -15,18 +15,148 @@
 
 #include "os3/base/WebServiceControl.h"
 
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <sstream>
+
+#include "os3/base/Observer.h"
+#include "os3/libnorad/cOrbit.h"
+#include "os3/libnorad/cTLE.h"
+#include "os3/mobility/LUTMotionMobility.h"
 
 Define_Module(WebServiceControl);
 
+WebServiceControl::WebServiceControl()
+    : curlInitialized(false), dataProvider(nullptr), httpProvider(nullptr), circuitBreaker(nullptr), replayData(false), defaultAltitude(0),
+      numFallbacks(0), numTLENotModified(0), numElementSetsChanged(0), numOrbitsReinitialized(0),
+      weatherRefreshInterval(0), refreshProvider(nullptr), refreshLocationsChanged(false),
+      stopRefresh(false), weatherSnapshot(nullptr), snapshotReaderActive(false), numWeatherRefreshes(0),
+      numSnapshotHits(0), numCoalesced(0)
+{
+}
+
+WebServiceControl::~WebServiceControl()
+{
+    stopWeatherRefresh();
+    delete weatherSnapshot.load();
+    delete refreshProvider;
+    delete dataProvider;
+    if (curlInitialized) {
+        curl_global_cleanup();
+    }
+}
+
 void WebServiceControl::initialize()
 {
+    // The implicit global initialization of libcurl is not thread safe, so it is done before any handle is created
+    // and before the refresh thread is started
+    if (!curlInitialized) {
+        if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+            error("Error in WebServiceControl::initialize(): libcurl could not be initialized");
+        }
+        curlInitialized = true;
+    }
+
     // Read parameters
-    altitudeCacheThreshold = par("altitudeCacheThreshold");
-    tleCacheThreshold = par("tleCacheThreshold");
-    weatherCacheThreshold = par("weatherCacheThreshold");
+    altitudeCache.setCapacity(par("altitudeCacheThreshold").longValue());
+    tleCache.setCapacity(par("tleCacheThreshold").longValue());
+    weatherCache.setCapacity(par("weatherCacheThreshold").longValue());
+    altitudeCache.setTimeToLive(par("altitudeCacheTTL").doubleValue());
+    tleCache.setTimeToLive(par("tleCacheTTL").doubleValue());
+    weatherCache.setTimeToLive(par("weatherCacheTTL").doubleValue());
+
+    const std::string cacheClock = par("cacheClock").stringValue();
+    if (cacheClock != "simulation" && cacheClock != "wall") {
+        error("Error in WebServiceControl::initialize(): cacheClock has to be \"simulation\" or \"wall\"");
+    }
+    cacheWallClock = (cacheClock == "wall");
+
+    weatherGridResolution = par("weatherGridResolution");
+    altitudeGridResolution = par("altitudeGridResolution");
+    interpolateAltitude = par("interpolateAltitude");
+    if (weatherGridResolution < 0 || altitudeGridResolution < 0) {
+        error("Error in WebServiceControl::initialize(): Grid resolutions must not be negative");
+    }
+    if (interpolateAltitude && altitudeGridResolution == 0) {
+        error("Error in WebServiceControl::initialize(): interpolateAltitude requires altitudeGridResolution > 0");
+    }
     weatherApiKey = par("apiKeyWeather").stringValue();
     altitudeUsername = par("usernameAltitude").stringValue();
+    defaultAltitude = par("defaultAltitude");
+    weatherServiceUrl = par("weatherServiceUrl").stringValue();
+    altitudeServiceUrl = par("altitudeServiceUrl").stringValue();
+    tleServiceUrl = par("tleServiceUrl").stringValue();
+    tleStoreDirectory = par("tleStoreDirectory").stringValue();
+
+    // Create the data provider
+    const std::string provider = par("dataProvider").stringValue();
+    const std::string dataDirectory = par("dataDirectory").stringValue();
+    if (provider == "http" || provider == "record") {
+        httpProvider = new HttpDataProvider(par("maxParallelRequests").longValue(),
+                                            static_cast< long >(par("connectTimeout").doubleValue() * 1000),
+                                            static_cast< long >(par("requestTimeout").doubleValue() * 1000));
+        circuitBreaker = new CircuitBreakerDataProvider(httpProvider, par("circuitBreakerThreshold").longValue(),
+                                                        par("circuitBreakerBackoff").doubleValue(),
+                                                        par("circuitBreakerMaxBackoff").doubleValue(),
+                                                        par("latencyBudget").doubleValue());
+        dataProvider = (provider == "record") ? new RecordingDataProvider(circuitBreaker, dataDirectory)
+                                              : static_cast< DataProvider* >(circuitBreaker);
+    } else if (provider == "file" || provider == "replay") {
+        dataProvider = new FileDataProvider(dataDirectory);
+        replayData = (provider == "replay");
+    } else {
+        error("Error in WebServiceControl::initialize(): dataProvider has to be \"http\", \"file\", \"record\" or \"replay\"");
+    }
+
+    // Prefetch phase: fetch the data for all ground stations and TLE files concurrently before the first event
+    const bool prefetchWeather = par("prefetchWeatherData");
+    const bool prefetchAltitude = par("prefetchAltitudeData");
+
+    std::vector< std::string > tleFiles;
+    std::istringstream tleFileStream(par("prefetchTLEFiles").stringValue());
+    std::string tleFile;
+    while (tleFileStream >> tleFile) {
+        tleFiles.push_back(tleFile);
+    }
+
+    std::vector< std::pair< double, double > > locations;
+    if (prefetchWeather || prefetchAltitude) {
+        collectStationLocations(simulation.getSystemModule(), locations);
+    }
+
+    if (!locations.empty() || !tleFiles.empty()) {
+        prefetch(locations, prefetchWeather, prefetchAltitude, tleFiles);
+    }
+
+    // Background refresh of the weather data of all ground stations (and of further locations once they are queried);
+    // snapshot answers bypass the data provider, so a recording would miss them
+    weatherRefreshInterval = par("weatherRefreshInterval");
+    if (weatherRefreshInterval > 0 && provider == "http") {
+        refreshProvider = new CircuitBreakerDataProvider(
+                new HttpDataProvider(par("maxParallelRequests").longValue(),
+                                     static_cast< long >(par("connectTimeout").doubleValue() * 1000),
+                                     static_cast< long >(par("requestTimeout").doubleValue() * 1000)),
+                par("circuitBreakerThreshold").longValue(), par("circuitBreakerBackoff").doubleValue(),
+                par("circuitBreakerMaxBackoff").doubleValue(), 0);
+
+        if (locations.empty()) {
+            collectStationLocations(simulation.getSystemModule(), locations);
+        }
+        for (std::size_t i = 0; i < locations.size(); i++) {
+            registerWeatherLocation(locations[i].first, locations[i].second);
+        }
+        refreshThread = std::thread(&WebServiceControl::refreshWeather, this);
+    } else if (weatherRefreshInterval > 0) {
+        EV << "Warning in WebServiceControl::initialize(): weatherRefreshInterval is ignored, it is only supported "
+              "by the data provider \"http\"." << std::endl;
+    }
 
     EV << "Web services are now available!" << std::endl;
 }
@@ -36,12 +166,57 @@ void WebServiceControl::handleMessage(cMessage* msg)
     error("Error in WebServiceControl::handleMessage(): This module is not able to handle messages");
 }
 
+void WebServiceControl::finish()
+{
+    stopWeatherRefresh();
+
+    recordScalar("webRequests", (httpProvider != nullptr) ? httpProvider->getNumRequests() : 0);
+    recordScalar("webNewConnections", (httpProvider != nullptr) ? httpProvider->getNumConnects() : 0);
+    recordScalar("dataProviderRequests", dataProvider->getNumRequests());
+    recordScalar("webFallbacks", numFallbacks);
+    recordScalar("webRequestsCoalesced", numCoalesced.load());
+    if (refreshProvider != nullptr) {
+        recordScalar("weatherRefreshes", numWeatherRefreshes.load());
+        recordScalar("weatherSnapshotHits", numSnapshotHits);
+    }
+    if (circuitBreaker != nullptr) {
+        recordScalar("webWaitTime", circuitBreaker->getTotalWaitTime());
+        recordScalar("webRequestsRejected", circuitBreaker->getNumRejected());
+        recordScalar("webCircuitOpened", circuitBreaker->getNumOpened());
+        recordScalar("webCircuitHalfOpened", circuitBreaker->getNumHalfOpened());
+    }
+
+    recordScalar("altitudeCacheHits", altitudeCache.hits());
+    recordScalar("altitudeCacheMisses", altitudeCache.misses());
+    recordScalar("altitudeCacheEvictions", altitudeCache.evictions());
+    recordScalar("altitudeCacheExpirations", altitudeCache.expirations());
+    recordScalar("weatherCacheHits", weatherCache.hits());
+    recordScalar("weatherCacheMisses", weatherCache.misses());
+    recordScalar("weatherCacheEvictions", weatherCache.evictions());
+    recordScalar("weatherCacheExpirations", weatherCache.expirations());
+    recordScalar("tleCacheHits", tleCache.hits());
+    recordScalar("tleCacheMisses", tleCache.misses());
+    recordScalar("tleCacheEvictions", tleCache.evictions());
+    recordScalar("tleCacheExpirations", tleCache.expirations());
+    recordScalar("tleNotModified", numTLENotModified);
+    recordScalar("tleElementSetsChanged", numElementSetsChanged);
+    recordScalar("tleOrbitsReinitialized", numOrbitsReinitialized);  // only orbits handed out by getOrbit()
+}
+
+double WebServiceControl::getCacheTime() const
+{
+    if (cacheWallClock) {
+        return std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    return simTime().dbl();
+}
+
 std::string WebServiceControl::getRequestStringWeatherData(const double& latitude, const double& longitude)
 {
     std::ostringstream requestStream;
 
     // Create URL
-    requestStream << "http://free.worldweatheronline.com/feed/weather.ashx?";
+    requestStream << weatherServiceUrl << "?";
 
     // Check if URL exists
 //    if (urlExist("http://free.worldweatheronline.com/") == false) {
@@ -72,7 +247,7 @@ std::string WebServiceControl::getRequestStringAltitudeData(const double& latitu
 //    }
 
     // Create URL
-    requestStream << "http://api.geonames.org/astergdem?";
+    requestStream << altitudeServiceUrl << "?";
 
     // Latitude and longitude
     requestStream << "lat=" << latitude << "&lng=" << longitude;
@@ -88,7 +263,7 @@ std::string WebServiceControl::getRequestStringTLEData(std::string fileName)
     std::ostringstream requestStream;
 
     // Create URL
-    requestStream << "http://www.celestrak.com/NORAD/elements/" << fileName;
+    requestStream << tleServiceUrl << fileName;
 
     // Check if URL exists
 //    if (urlExist(requestStream.str()) == false) {
@@ -99,336 +274,779 @@ std::string WebServiceControl::getRequestStringTLEData(std::string fileName)
     return requestStream.str();
 }
 
-/**
- * @brief Conversion of cURL result to string
- * This method transforms a cURL result set into a std::string value. The intention of this method is to reduce the cost for additional saves
- * of result files on user's hard disk. The method is taken from http://www.c-plusplus.de/forum/262216
- * @author Dennis Kaulbars
- * @version 0.1
- * Method defined
- */
-size_t write_data(char* ptr, size_t size, size_t nmemb, std::string* targetString)
-{
-    if (targetString) {
-        targetString->append(ptr, size * nmemb);
-        return size * nmemb;
-    }
-    return 0;
-}
-
 bool WebServiceControl::urlExist(std::string url)
 {
-    // Check if url is set
-    if (url.size() == 0) {
+    // Check if url is set; without network access (or budget) no url can be checked
+    if (url.size() == 0 || circuitBreaker == nullptr || circuitBreaker->getRemainingBudget() <= 0) {
         return false;
     }
 
-    // Create request, Output is set to null-device, because it is not needed (only interested in status)
-    FILE *null_device = std::fopen("/dev/null", "w");
-    std::string resultString;
+    // Create request, only the status is of interest (no body is transferred)
+    const long timeout = static_cast< long >(std::min(5.0, circuitBreaker->getRemainingBudget()) * 1000);
     CURL* easyHandle = curl_easy_init();
-    curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT, 5);
-    curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT, 5);
+    curl_easy_setopt(easyHandle, CURLOPT_TIMEOUT_MS, std::max(1L, timeout));
+    curl_easy_setopt(easyHandle, CURLOPT_CONNECTTIMEOUT_MS, std::max(1L, timeout));
+    curl_easy_setopt(easyHandle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easyHandle, CURLOPT_NOBODY, 1L);
     curl_easy_setopt(easyHandle, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(easyHandle, CURLOPT_WRITEDATA, null_device);
 
     // Exequte check
-    if (curl_easy_perform(easyHandle) != 0) {
-        curl_easy_cleanup(easyHandle);
-        return false;
-    }
+    const double start = DataProvider::getWallClock();
+    const CURLcode code = curl_easy_perform(easyHandle);
+    circuitBreaker->addWaitTime(DataProvider::getWallClock() - start);
 
     curl_easy_cleanup(easyHandle);
-    return true;
+    return code == CURLE_OK;
 }
 
-std::string WebServiceControl::requestWeatherData(const double& latitude, const double& longitude)
+WeatherData WebServiceControl::requestWeatherData(const double& latitude, const double& longitude)
 {
-    // Check if TLE data with name fileName is in cache
-    std::map< std::pair< double, double >,std::string >::iterator cacheIt = weatherCache.find(
-            std::pair< double, double >(latitude, longitude));
-    if (cacheIt != weatherCache.end()) {
-        // Entry found! Return content of weatherCache => finish
-        std::string resultString = cacheIt->second;
-        return resultString;
+    // Check if weather data for the location is in cache
+    const WeatherData* cached = weatherCache.get(std::make_pair(latitude, longitude), getCacheTime());
+    if (cached != nullptr) {
+        // Entry found! Return parsed content of weatherCache => finish
+        return *cached;
     }
 
-    // Initialize cURL variables
-    CURL* easyHandle = curl_easy_init();
+    // Fetch data from the data provider
+    DataRequest request = createRequest(DataRequest::WEATHER, latitude, longitude);
+    const bool success = fetchData(request);
 
-    // Create request string
-    std::string requestString = getRequestStringWeatherData(latitude, longitude);
-
-    // Take necessary options for cURL handler
-    std::string resultString;
-    curl_easy_setopt(easyHandle, CURLOPT_URL, requestString.c_str());
-    curl_easy_setopt(easyHandle, CURLOPT_WRITEDATA, &resultString);
-    curl_easy_setopt(easyHandle, CURLOPT_WRITEFUNCTION, &write_data);
+    // Without fresh data, the last known (expired) weather or default weather (no rain) is used
+    if (!success) {
+        numFallbacks++;
+        const WeatherData* stale = weatherCache.getStale(std::make_pair(latitude, longitude));
+        return (stale != nullptr) ? *stale : evaluateWeatherInformation("");
+    }
 
-    // Fetch data from website, result is saved in resultString
-    curl_easy_perform(easyHandle);
-    curl_easy_cleanup(easyHandle);
+    // Parse the data once and save the result in cache for further requests
+    WeatherData weatherData = evaluateWeatherInformation(request.result);
+    weatherCache.put(std::make_pair(latitude, longitude), weatherData, getCacheTime());
+    return weatherData;
+}
 
-    // Save resultString in cache for further requests if cache is not full
-    if (weatherCache.size() < weatherCacheThreshold) {
-        std::pair< double, double > temp = std::pair< double, double >(latitude, longitude);
-        weatherCache.insert(std::pair< std::pair< double, double >,std::string >(temp, resultString));
+bool WebServiceControl::requestAltitudeData(const double& latitude, const double& longitude, double& altitude)
+{
+    // Fetch data from the data provider
+    DataRequest request = createRequest(DataRequest::ALTITUDE, latitude, longitude);
+    if (!fetchData(request) || request.result.find_first_of("0123456789") == std::string::npos) {
+        return false;
     }
 
-    return resultString;
+    // -9999 marks locations without data
+    altitude = std::atof(request.result.c_str());
+    return altitude != -9999;
 }
 
-double WebServiceControl::requestAltitudeData(const double& latitude, const double& longitude)
+std::shared_ptr< const TLECatalog > WebServiceControl::requestTLEData(std::string fileName)
 {
-    // Initialize cURL variables
-    CURL* easyHandle = curl_easy_init();
+    // Check if TLE data with name fileName is in cache
+    const std::shared_ptr< const TLECatalog >* cached = tleCache.get(fileName, getCacheTime());
+    if (cached != nullptr) {
+        //Entry found! Return parsed TLE file => finish
+        return *cached;
+    }
 
-    // Create request string
-    std::string requestString = getRequestStringAltitudeData(latitude, longitude);
+    // Entry not in cache, load data and save them in cache for further requests
 
-    // Take necessary options for cURL handler
-    std::string resultString;
-    curl_easy_setopt(easyHandle, CURLOPT_URL, requestString.c_str());
-    curl_easy_setopt(easyHandle, CURLOPT_WRITEDATA, &resultString);
-    curl_easy_setopt(easyHandle, CURLOPT_WRITEFUNCTION, &write_data);
+    // Fetch data from the data provider (an unchanged file is only confirmed by the web service)
+    DataRequest request = createRequest(DataRequest::TLE, 0, 0, fileName);
+    addTLEValidators(request);
+    const bool success = fetchData(request);
+
+    // Without fresh data, the last known (expired or stored) version of the file is used
+    if (!success) {
+        const std::shared_ptr< const TLECatalog >* stale = tleCache.getStale(fileName);
+        const tleVersion* version = getTLEVersion(fileName);
+        if (stale == nullptr && version == nullptr) {
+            error("Error in WebServiceControl::requestTLEData(): Could not fetch TLE file \"%s\"", fileName.c_str());
+        }
+        numFallbacks++;
+        return (stale != nullptr) ? *stale : version->catalog;
+    }
 
-    // Fetch data from website, result is saved in resultString
-    curl_easy_perform(easyHandle);
-    curl_easy_cleanup(easyHandle);
+    // Parse the file once and save it in cache for further requests
+    return cacheTLEData(request);
+}
 
-    return std::atof(resultString.c_str());
+std::shared_ptr< const TLECatalog > WebServiceControl::parseTLEFile(const std::string& dataString)
+{
+    std::shared_ptr< TLECatalog > tleFile = std::make_shared< TLECatalog >();
+    tleFile->parse(dataString);
+    return tleFile;
 }
 
-std::string WebServiceControl::requestTLEData(std::string fileName)
+// Converts a numeric field of the weather CSV without copying it; empty fields are 0
+static double parseWeatherField(const std::string& dataString, const std::size_t& begin, const std::size_t& end)
 {
-    // Check if TLE data with name fileName is in cache
-    std::map< std::string, std::string >::iterator cacheIt = tleCache.find(fileName);
-    if (cacheIt != tleCache.end()) {
-        //Entry found! Return content of TLEfile => finish
-        std::string resultString = cacheIt->second;
-        return resultString;
-    }
+    return (begin < end) ? std::strtod(dataString.c_str() + begin, nullptr) : 0;
+}
 
-    // Entry not in cache, load data and save them in cache for further requests
+WeatherData WebServiceControl::evaluateWeatherInformation(std::string dataString)
+{
+    WeatherData resultData;
 
-    // Initialize cURL variables
-    CURL* easyHandle = curl_easy_init();
+    // Go to line 10 (contains interesting data) => skip first 9 lines
+    std::size_t pos = 0;
+    for (int i = 0; i < 9 && pos < dataString.size(); i++) {
+        const std::size_t newline = dataString.find('\n', pos);
+        pos = (newline == std::string::npos) ? dataString.size() : newline + 1;
+    }
+    std::size_t lineEnd = dataString.find('\n', pos);
+    if (lineEnd == std::string::npos) {
+        lineEnd = dataString.size();
+    }
 
-    // Create request string
-    std::string requestString = getRequestStringTLEData(fileName);
+    // Split weatherLine into its fields in one pass (missing fields stay empty)
+    // syntax: date,tempMaxC,tempMaxF,tempMinC,tempMinF,windspeedMiles,windspeedKmph,winddirDegree,winddir16Point,weatherCode,weatherIconUrl,weatherDesc,precipMM
+    const int numFields = 13;
+    std::size_t fieldBegin[numFields];
+    std::size_t fieldEnd[numFields];
+    for (int i = 0; i < numFields; i++) {
+        fieldBegin[i] = fieldEnd[i] = lineEnd;
+        if (pos <= lineEnd) {
+            std::size_t comma = dataString.find(',', pos);
+            if (comma == std::string::npos || comma > lineEnd) {
+                comma = lineEnd;
+            }
+            fieldBegin[i] = pos;
+            fieldEnd[i] = comma;
+            pos = comma + 1;
+        }
+    }
 
-    // Take necessary options for cURL handler
-    std::string resultString;
-    curl_easy_setopt(easyHandle, CURLOPT_URL, requestString.c_str());
-    curl_easy_setopt(easyHandle, CURLOPT_WRITEDATA, &resultString);
-    curl_easy_setopt(easyHandle, CURLOPT_WRITEFUNCTION, &write_data);
+    resultData.date = dataString.substr(fieldBegin[0], fieldEnd[0] - fieldBegin[0]);
+    resultData.tempMaxC = parseWeatherField(dataString, fieldBegin[1], fieldEnd[1]);
+    resultData.tempMaxF = parseWeatherField(dataString, fieldBegin[2], fieldEnd[2]);
+    resultData.tempMinC = parseWeatherField(dataString, fieldBegin[3], fieldEnd[3]);
+    resultData.tempMinF = parseWeatherField(dataString, fieldBegin[4], fieldEnd[4]);
+    resultData.windSpeedMiles = parseWeatherField(dataString, fieldBegin[5], fieldEnd[5]);
+    resultData.windSpeedKmph = parseWeatherField(dataString, fieldBegin[6], fieldEnd[6]);
+    resultData.windDirDegree = parseWeatherField(dataString, fieldBegin[7], fieldEnd[7]);
+    resultData.windDir16Point = parseWeatherField(dataString, fieldBegin[8], fieldEnd[8]);
+    resultData.weatherCode = parseWeatherField(dataString, fieldBegin[9], fieldEnd[9]);
+    resultData.weatherIconURL = dataString.substr(fieldBegin[10], fieldEnd[10] - fieldBegin[10]);
+    resultData.weatherDesc = dataString.substr(fieldBegin[11], fieldEnd[11] - fieldBegin[11]);
+    resultData.precipMM = parseWeatherField(dataString, fieldBegin[12], fieldEnd[12]);
 
-    // Fetch data from website, result is saved in resultString
-    curl_easy_perform(easyHandle);
-    curl_easy_cleanup(easyHandle);
+    return resultData;
+}
 
-    // Save resultString in cache for further requests if cache is not full
-    if (tleCache.size() < tleCacheThreshold) {
-        tleCache.insert(std::pair< std::string, std::string >(fileName, resultString));
+TLEData WebServiceControl::evaluateTLEData(const TLECatalog& tleFile, unsigned int numSat)
+{
+    TLEData resultData;
+
+    // Check if number of satellites contained in the file fits to numSat
+    if (numSat >= tleFile.size()) {
+        error("Error in WebServiceControl::evaluateTLEData(): numSat too big (greater or equal than number of satellites contained in textfile)");
+        return resultData;
     }
 
-    return resultString;
+    resultData.tleName = tleFile.getName(numSat);
+    resultData.tleLine1 = tleFile.getLine1(numSat);
+    resultData.tleLine2 = tleFile.getLine2(numSat);
+    return resultData;
 }
 
-WeatherData WebServiceControl::evaluateWeatherInformation(std::string dataString)
+TLEData WebServiceControl::evaluateTLEData(const TLECatalog& tleFile, std::string satName)
 {
-    WeatherData resultData;
+    TLEData resultData;
 
-    // Go to line 10 (contains interesting data) => skip first 9 lines
-    for (int i = 0; i < 9; i++) {
-        dataString = dataString.erase(0, dataString.find("\n") + 1);
+    // Find satellite with name satName
+    const long index = tleFile.find(satName);
+    if (index < 0) {
+        error("Error in WebServiceControl::evaluateTLEData(): satellite can not be found!");
+        return resultData;
     }
 
-    // Evaluate weatherLine. syntax: date,tempMaxC,tempMaxF,tempMinC,tempMinF,windspeedMiles,windspeedKmph,winddirDegree,winddir16Point,weatherCode,weatherIconUrl,weatherDesc,precipMM
-    resultData.date = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
+    resultData.tleName = tleFile.getName(index);
+    resultData.tleLine1 = tleFile.getLine1(index);
+    resultData.tleLine2 = tleFile.getLine2(index);
+    return resultData;
+}
 
-    std::string temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.tempMaxC = std::atof(temp.c_str());
+WeatherData WebServiceControl::getWeatherData(const double& latitude, const double& longitude)
+{
+    // Fetch current weather data for the grid point of the location
+    const std::pair< double, double > gridPoint = quantizeLocation(latitude, longitude, weatherGridResolution);
+
+    // Registered locations are kept up to date by the refresh thread
+    if (refreshProvider != nullptr) {
+        WeatherData weatherData;
+        if (readWeatherSnapshot(gridPoint, weatherData)) {
+            numSnapshotHits++;
+            return weatherData;
+        }
+        registerWeatherLocation(latitude, longitude);
+    }
+    return requestWeatherData(gridPoint.first, gridPoint.second);
+}
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.tempMaxF = std::atof(temp.c_str());
+void WebServiceControl::registerWeatherLocation(const double& latitude, const double& longitude)
+{
+    const std::pair< double, double > gridPoint = quantizeLocation(latitude, longitude, weatherGridResolution);
+    if (!registeredLocations.insert(gridPoint).second) {
+        return;
+    }
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.tempMinC = std::atof(temp.c_str());
+    std::lock_guard< std::mutex > lock(refreshMutex);
+    refreshLocations.push_back(gridPoint);
+    refreshLocationsChanged = true;
+    refreshCondition.notify_one();
+}
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.tempMinF = std::atof(temp.c_str());
+bool WebServiceControl::readWeatherSnapshot(const std::pair< double, double >& gridPoint, WeatherData& weatherData)
+{
+    snapshotReaderActive.store(true);
+    const WeatherSnapshot* snapshot = weatherSnapshot.load();
+    bool found = false;
+    if (snapshot != nullptr) {
+        WeatherSnapshot::const_iterator it = snapshot->find(gridPoint);
+        if (it != snapshot->end()) {
+            weatherData = it->second;
+            found = true;
+        }
+    }
+    snapshotReaderActive.store(false);
+    return found;
+}
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.windSpeedMiles = std::atof(temp.c_str());
+void WebServiceControl::refreshWeather()
+{
+    std::unique_lock< std::mutex > lock(refreshMutex);
+    while (!stopRefresh) {
+        std::vector< std::pair< double, double > > locations = refreshLocations;
+        refreshLocationsChanged = false;
+        lock.unlock();
+
+        // Fetch the weather data of all registered locations (without holding the lock)
+        std::vector< DataRequest > requests;
+        for (std::size_t i = 0; i < locations.size(); i++) {
+            requests.push_back(createRequest(DataRequest::WEATHER, locations[i].first, locations[i].second));
+        }
+        fetchCoalesced(refreshProvider, requests, nullptr);
+
+        // Build the next snapshot; locations which could not be fetched keep their last data
+        const WeatherSnapshot* oldSnapshot = weatherSnapshot.load();
+        WeatherSnapshot* newSnapshot = (oldSnapshot != nullptr) ? new WeatherSnapshot(*oldSnapshot) : new WeatherSnapshot();
+        for (std::size_t i = 0; i < requests.size(); i++) {
+            if (requests[i].success) {
+                (*newSnapshot)[locations[i]] = evaluateWeatherInformation(requests[i].result);
+            }
+        }
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.windSpeedKmph = std::atof(temp.c_str());
+        // Publish the snapshot; the old one is freed as soon as the simulation thread does not read it anymore
+        weatherSnapshot.store(newSnapshot);
+        while (snapshotReaderActive.load()) {
+            std::this_thread::yield();
+        }
+        delete oldSnapshot;
+        numWeatherRefreshes++;
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.windDirDegree = std::atof(temp.c_str());
+        lock.lock();
+        refreshCondition.wait_for(lock, std::chrono::duration< double >(weatherRefreshInterval),
+                                  [this]() { return stopRefresh || refreshLocationsChanged; });
+    }
+}
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.windDir16Point = std::atof(temp.c_str());
+void WebServiceControl::stopWeatherRefresh()
+{
+    if (!refreshThread.joinable()) {
+        return;
+    }
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.weatherCode = std::atof(temp.c_str());
+    {
+        std::lock_guard< std::mutex > lock(refreshMutex);
+        stopRefresh = true;
+    }
+    refreshCondition.notify_one();
+    refreshThread.join();
+}
+
+double WebServiceControl::getAltitudeData(const double& latitude, const double& longitude)
+{
+    std::vector< std::pair< double, double > > points;
+    std::vector< double > weights;
+    getAltitudeGridPoints(latitude, longitude, points, weights);
+
+    double currentAltitude = 0;
+    for (std::size_t i = 0; i < points.size(); i++) {
+        currentAltitude += weights[i] * getGridAltitude(points[i]);
+    }
+    return currentAltitude;
+}
 
-    resultData.weatherIconURL = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
+double WebServiceControl::getGridAltitude(const std::pair< double, double >& point)
+{
+    // Check if there is a matching cached value (the entry becomes the most recently used one)
+    const double* cached = altitudeCache.get(point, getCacheTime());
+    if (cached != nullptr) {
+        return *cached;
+    }
 
-    resultData.weatherDesc = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
+    // Value is not cached => fetch current altitude data
+    double currentAltitude = 0;
+    if (!requestAltitudeData(point.first, point.second, currentAltitude)) {
+        // Use the last known (expired) altitude or the default altitude; the value is not cached, so it is requested
+        // again later
+        numFallbacks++;
+        const double* stale = altitudeCache.getStale(point);
+        EV << "Warning in WebServiceControl::getGridAltitude(): No altitude data for " << point.first << ", "
+           << point.second << ", using " << (stale != nullptr ? "cached" : "default") << " value." << std::endl;
+        return (stale != nullptr) ? *stale : defaultAltitude;
+    }
 
-    temp = dataString.substr(0, dataString.find(","));
-    dataString.erase(0, dataString.find(",") + 1);
-    resultData.precipMM = std::atof(temp.c_str());
+    // Add the value to the cache
+    cacheAltitudeData(point.first, point.second, currentAltitude);
 
-    return resultData;
+    return currentAltitude;
 }
 
-TLEData WebServiceControl::evaluateTLEData(std::string dataString, unsigned int numSat)
+std::pair< double, double > WebServiceControl::quantizeLocation(const double& latitude, const double& longitude,
+                                                                const double& resolution)
 {
-    TLEData resultData;
-
-    // Count number of lines in text file => number of lines / 3 = number of satellites in textfile
-    unsigned int numSatTXT = 0;
-    std::string tmpDataString = dataString;
+    if (resolution <= 0) {
+        return std::make_pair(latitude, longitude);
+    }
 
-    // Find out number of satellites
-    while (tmpDataString.empty() == false) {
-        tmpDataString.erase(0, tmpDataString.find("\n") + 1);
-        numSatTXT++;
+    // The grid point is derived from its integer index, so equal indices always yield bitwise equal keys
+    const long latIndex = std::lround(latitude / resolution);
+    const long lonIndex = std::lround(longitude / resolution);
+    double gridLongitude = lonIndex * resolution;
+    if (gridLongitude >= 180) {
+        gridLongitude -= 360;
     }
-    numSatTXT = numSatTXT / 3;
+    return std::make_pair(std::max(-90.0, std::min(90.0, latIndex * resolution)), gridLongitude);
+}
 
-    // Check if number of satellites contained in dataString fits to numSat
-    if (numSat >= numSatTXT) {
-        error("Error in WebServiceControl::evaluateTLEData(): numSat too big (greater or equal than number of satellites contained in textfile)");
-        return resultData;
+void WebServiceControl::getAltitudeGridPoints(const double& latitude, const double& longitude,
+                                              std::vector< std::pair< double, double > >& points,
+                                              std::vector< double >& weights) const
+{
+    points.clear();
+    weights.clear();
+
+    if (!interpolateAltitude) {
+        points.push_back(quantizeLocation(latitude, longitude, altitudeGridResolution));
+        weights.push_back(1);
+        return;
     }
 
-    // Go to line numSat*3
-    for (unsigned int i = 0; i < numSat * 3; i++) {
-        dataString.erase(0, dataString.find("\n") + 1);
+    // Lower left corner of the grid cell and relative position within the cell
+    const double res = altitudeGridResolution;
+    const long latIndex = static_cast< long >(std::floor(latitude / res));
+    const long lonIndex = static_cast< long >(std::floor(longitude / res));
+    const double fLat = latitude / res - latIndex;
+    const double fLon = longitude / res - lonIndex;
+
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            const double weight = (i == 0 ? 1 - fLat : fLat) * (j == 0 ? 1 - fLon : fLon);
+
+            // Corners without influence are not fetched (e.g., location lies exactly on a grid line)
+            if (weight <= 0) {
+                continue;
+            }
+            points.push_back(quantizeLocation((latIndex + i) * res, (lonIndex + j) * res, res));
+            weights.push_back(weight);
+        }
     }
+}
+
+TLEData WebServiceControl::getTLEData(std::string fileName, unsigned int numSat)
+{
+    std::cout << "satellite index: " << numSat << std::endl;
+    // Fetch parsed TLE data file
+    std::shared_ptr< const TLECatalog > tleFile = requestTLEData(fileName);
 
-    // Fetch data of satellite numSat
-    resultData.tleName = dataString.substr(0, dataString.find("\n"));
-    dataString.erase(0, dataString.find("\n") + 1);
+    // Evaluate data and return result
+    return evaluateTLEData(*tleFile, numSat);
+}
 
-    resultData.tleLine1 = dataString.substr(0, dataString.find("\n"));
-    dataString.erase(0, dataString.find("\n") + 1);
+TLEData WebServiceControl::getTLEData(std::string fileName, std::string satName)
+{
+    // Fetch parsed TLE data file
+    std::shared_ptr< const TLECatalog > tleFile = requestTLEData(fileName);
 
-    resultData.tleLine2 = dataString.substr(0, dataString.find("\n"));
-    dataString.erase(0, dataString.find("\n") + 1);
+    // Evaluate data and return result
+    return evaluateTLEData(*tleFile, satName);
+}
 
-    // Pretty up name in TLE data
-    //resultData.tleName.erase(resultData.tleName.find("  "), resultData.tleName.size() - resultData.tleName.find(" "));
+std::shared_ptr< const cOrbit > WebServiceControl::getOrbit(std::string fileName, std::string satName)
+{
+    std::shared_ptr< const TLECatalog > tleFile = requestTLEData(fileName);
+    const long index = tleFile->find(satName);
+    if (index < 0) {
+        error("Error in WebServiceControl::getOrbit(): Satellite \"%s\" not found in TLE file \"%s\"", satName.c_str(),
+              fileName.c_str());
+    }
 
-    return resultData;
+    // The orbit is initialized once per element set (see updateOrbits())
+    std::shared_ptr< const cOrbit >& orbit = tleOrbits[fileName][tleFile->getCatalogNumber(index)];
+    if (!orbit) {
+        orbit = std::make_shared< cOrbit >(tleFile->getTle(index));
+    }
+    return orbit;
 }
 
-TLEData WebServiceControl::evaluateTLEData(std::string dataString, std::string satName)
+void WebServiceControl::cacheWeatherData(const double& latitude, const double& longitude, const std::string& data)
 {
-    TLEData resultData;
+    weatherCache.put(std::make_pair(latitude, longitude), evaluateWeatherInformation(data), getCacheTime());
+}
 
-    // Find satellite with name satName
-    unsigned int pos = dataString.find(satName);
-    //const size_t pos = dataString.find(satName);
+std::shared_ptr< const TLECatalog > WebServiceControl::cacheTLEData(const DataRequest& request)
+{
+    tleVersion* version = getTLEVersion(request.fileName);
 
-    if (pos == std::string::npos) {
-        error("Error in WebServiceControl::evaluateTLEData(): satellite can not be found!");
-        return resultData;
-    } else {
-        // Extract TLE data and parse them into the result struct
-        dataString = dataString.erase(0, pos);
+    // Unchanged file: the parsed version and all orbits stay valid
+    if (request.notModified && version != nullptr) {
+        if (!request.etag.empty() || !request.lastModified.empty()) {
+            version->etag = request.etag;
+            version->lastModified = request.lastModified;
+        }
+        numTLENotModified++;
+        tleCache.put(request.fileName, version->catalog, getCacheTime());
+        return version->catalog;
+    }
+
+    std::shared_ptr< const TLECatalog > tleFile = parseTLEFile(request.result);
+    if (version != nullptr) {
+        updateOrbits(request.fileName, *version->catalog, *tleFile);
+    }
 
-        resultData.tleName = dataString.substr(0, dataString.find("\n"));
-        dataString.erase(0, dataString.find("\n") + 1);
+    tleVersion& current = tleVersions[request.fileName];
+    current.etag = request.etag;
+    current.lastModified = request.lastModified;
+    current.catalog = tleFile;
+    if (tleStoreDirectory != "") {
+        storeTLEVersion(request.fileName, current, request.result);
+    }
 
-        resultData.tleLine1 = dataString.substr(0, dataString.find("\n"));
-        dataString.erase(0, dataString.find("\n") + 1);
+    tleCache.put(request.fileName, tleFile, getCacheTime());
+    return tleFile;
+}
 
-        resultData.tleLine2 = dataString.substr(0, dataString.find("\n"));
+void WebServiceControl::addTLEValidators(DataRequest& request)
+{
+    const tleVersion* version = getTLEVersion(request.fileName);
+    if (version != nullptr) {
+        request.etag = version->etag;
+        request.lastModified = version->lastModified;
+    }
+}
+
+WebServiceControl::tleVersion* WebServiceControl::getTLEVersion(const std::string& fileName)
+{
+    std::map< std::string, tleVersion >::iterator it = tleVersions.find(fileName);
+    if (it != tleVersions.end()) {
+        return &it->second;
+    }
+    if (tleStoreDirectory == "") {
+        return nullptr;
     }
 
-    // Pretty up name in TLE data
-    //resultData.tleName.erase(resultData.tleName.find("  "), resultData.tleName.size() - resultData.tleName.find(" "));
+    // The store holds the file and its validators (ETag and Last-Modified, one per line)
+    const std::string storeName = tleStoreDirectory + "/" + fileName;
+    std::ifstream fileStream(storeName.c_str(), std::ios::binary);
+    if (!fileStream.good()) {
+        return nullptr;
+    }
+    std::ostringstream content;
+    content << fileStream.rdbuf();
+
+    tleVersion& version = tleVersions[fileName];
+    version.catalog = parseTLEFile(content.str());
+    std::ifstream validatorStream((storeName + ".validators").c_str());
+    std::getline(validatorStream, version.etag);
+    std::getline(validatorStream, version.lastModified);
+    return &version;
+}
 
-    return resultData;
+void WebServiceControl::storeTLEVersion(const std::string& fileName, const tleVersion& version, const std::string& data)
+{
+    // The file is replaced before its validators, so stored validators never belong to an older file
+    const std::string storeName = tleStoreDirectory + "/" + fileName;
+    const std::string names[2] = { storeName, storeName + ".validators" };
+    const std::string contents[2] = { data, version.etag + "\n" + version.lastModified + "\n" };
+    for (int i = 0; i < 2; i++) {
+        const std::string tempName = names[i] + ".tmp";
+        std::ofstream fileStream(tempName.c_str(), std::ios::binary | std::ios::trunc);
+        fileStream << contents[i];
+        fileStream.close();
+        if (!fileStream.good() || std::rename(tempName.c_str(), names[i].c_str()) != 0) {
+            std::remove(tempName.c_str());
+            EV << "Warning in WebServiceControl::storeTLEVersion(): Could not write " << names[i] << std::endl;
+            return;
+        }
+    }
 }
 
-WeatherData WebServiceControl::getWeatherData(const double& latitude, const double& longitude)
+void WebServiceControl::updateOrbits(const std::string& fileName, const TLECatalog& previous, const TLECatalog& current)
 {
-    // Fetch current weather data
-    std::string weatherData = requestWeatherData(latitude, longitude);
-    WeatherData currentWeatherData = evaluateWeatherInformation(weatherData);
+    std::vector< std::size_t > changed;
+    current.diff(previous, changed);
+    numElementSetsChanged += changed.size();
+
+    std::map< std::string, OrbitMap >::iterator fileOrbits = tleOrbits.find(fileName);
+    if (fileOrbits == tleOrbits.end()) {
+        return;
+    }
+    OrbitMap& orbits = fileOrbits->second;
+
+    // Orbits of satellites which were removed from the file are dropped
+    for (OrbitMap::iterator it = orbits.begin(); it != orbits.end();) {
+        if (current.findByCatalogNumber(it->first) < 0) {
+            orbits.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    // Only the orbits of changed element sets are initialized again, unchanged ones are kept
+    for (std::size_t i = 0; i < changed.size(); i++) {
+        OrbitMap::iterator it = orbits.find(current.getCatalogNumber(changed[i]));
+        if (it != orbits.end()) {
+            it->second = std::make_shared< cOrbit >(current.getTle(changed[i]));
+            numOrbitsReinitialized++;
+        }
+    }
 
-    return currentWeatherData;
+    EV << "WebServiceControl: " << changed.size() << " of " << current.size() << " element sets in " << fileName
+       << " changed" << std::endl;
 }
 
-double WebServiceControl::getAltitudeData(const double& latitude, const double& longitude)
+void WebServiceControl::cacheAltitudeData(const double& latitude, const double& longitude, const double& altitude)
 {
-    double currentAltitude = -9999;
+    altitudeCache.put(std::make_pair(latitude, longitude), altitude, getCacheTime());
+}
 
-    std::pair< double, double > key = std::make_pair(latitude, longitude);
+void WebServiceControl::collectStationLocations(cModule* module, std::vector< std::pair< double, double > >& locations)
+{
+    if (module == nullptr) {
+        return;
+    }
 
-    // Check if there is a matching cached value
-    try {
-        currentAltitude = altitudeCache.at(key); // Throws std::out_of_range
+    if (dynamic_cast< LUTMotionMobility* >(module) != nullptr) {
+        locations.push_back(std::make_pair(module->par("latitude").doubleValue(),
+                                           module->par("longitude").doubleValue()));
+    } else if (dynamic_cast< Observer* >(module) != nullptr) {
+        locations.push_back(std::make_pair(module->par("ObserverLatitude").doubleValue(),
+                                           module->par("ObserverLongitude").doubleValue()));
+    }
 
-        // Rearrange the map, such that the latest requested value comes last
-        altitudeCache.erase(key);
-        altitudeCache.insert(altitudeCache.end(), std::make_pair(key, currentAltitude));
+    for (cModule::SubmoduleIterator it(module); !it.end(); it++) {
+        collectStationLocations(it(), locations);
     }
-    catch (std::out_of_range& oor) {
-        // Value is not cached => fetch current altitude data
-        currentAltitude = requestAltitudeData(latitude, longitude);
+}
 
-        // Check if cached altitude is an existing value or an error occured (-9999)
-        if (currentAltitude == -9999) {
-            error("Error in WebServiceControl::getAltitudeData(): Fetched value for altitude data is invalid!");
-            return -9999;
+void WebServiceControl::prefetch(const std::vector< std::pair< double, double > >& locations, bool fetchWeather,
+                                 bool fetchAltitude, const std::vector< std::string >& tleFiles)
+{
+    std::vector< DataRequest > requests;
+    std::set< std::pair< double, double > > weatherRequested;
+    std::set< std::pair< double, double > > altitudeRequested;
+    std::set< std::string > tleRequested;
+    const double now = getCacheTime();
+
+    // Create one request per data item which is not cached yet (each item only once)
+    for (std::size_t i = 0; i < locations.size(); i++) {
+        // Data is requested for the grid points, which are also used as cache keys
+        if (fetchWeather) {
+            const std::pair< double, double > gridPoint =
+                    quantizeLocation(locations[i].first, locations[i].second, weatherGridResolution);
+            if (!weatherCache.contains(gridPoint, now) && weatherRequested.insert(gridPoint).second) {
+                requests.push_back(createRequest(DataRequest::WEATHER, gridPoint.first, gridPoint.second));
+            }
+        }
+        if (fetchAltitude) {
+            std::vector< std::pair< double, double > > gridPoints;
+            std::vector< double > weights;
+            getAltitudeGridPoints(locations[i].first, locations[i].second, gridPoints, weights);
+            for (std::size_t j = 0; j < gridPoints.size(); j++) {
+                if (!altitudeCache.contains(gridPoints[j], now) && altitudeRequested.insert(gridPoints[j]).second) {
+                    requests.push_back(createRequest(DataRequest::ALTITUDE, gridPoints[j].first, gridPoints[j].second));
+                }
+            }
+        }
+    }
+    for (std::size_t i = 0; i < tleFiles.size(); i++) {
+        if (!tleCache.contains(tleFiles[i], now) && tleRequested.insert(tleFiles[i]).second) {
+            requests.push_back(createRequest(DataRequest::TLE, 0, 0, tleFiles[i]));
+            addTLEValidators(requests.back());
         }
+    }
+
+    if (requests.empty()) {
+        return;
+    }
 
-        // Add the value to the cache
-        altitudeCache.insert(altitudeCache.end(), std::make_pair(key, currentAltitude));
+    EV << "WebServiceControl: prefetching " << requests.size() << " web service requests" << std::endl;
+    fetchCoalesced(dataProvider, requests, circuitBreaker);
+
+    // Populate caches
+    unsigned int failed = 0;
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        const DataRequest& request = requests[i];
+        if (!request.success) {
+            if (replayData) {
+                error("Error in WebServiceControl::prefetch(): No recorded data for %s", request.url.c_str());
+            }
+            failed++;
+            continue;
+        }
 
-        // Ensure that the size of the map does not get too large (this could happen, e.g., for mobile base stations)
-        // In such a case, delete the oldest element (the first in the map)
-        if (altitudeCache.size() > altitudeCacheThreshold)
-            altitudeCache.erase(altitudeCache.begin());
-    } // End catch
+        switch (request.type) {
+            case DataRequest::WEATHER:
+                cacheWeatherData(request.latitude, request.longitude, request.result);
+                break;
+            case DataRequest::ALTITUDE:
+                // An empty or invalid answer is not cached, getAltitudeData() will retry later
+                if (!request.result.empty() && std::atof(request.result.c_str()) != -9999) {
+                    cacheAltitudeData(request.latitude, request.longitude, std::atof(request.result.c_str()));
+                } else {
+                    failed++;
+                }
+                break;
+            case DataRequest::TLE:
+                cacheTLEData(request);
+                break;
+        }
+    }
 
-    return currentAltitude;
+    if (failed > 0) {
+        EV << "Warning in WebServiceControl::prefetch(): " << failed << " of " << requests.size()
+           << " requests failed, the data will be requested again when needed." << std::endl;
+    }
 }
 
-TLEData WebServiceControl::getTLEData(std::string fileName, unsigned int numSat)
+DataRequest WebServiceControl::createRequest(DataRequest::Type type, const double& latitude, const double& longitude,
+                                             const std::string& fileName)
 {
-    std::cout << "satellite index: " << numSat << std::endl;
-    // Fetch TLE data file
-    std::string dataString = requestTLEData(fileName);
+    DataRequest request;
+    request.type = type;
+    request.latitude = latitude;
+    request.longitude = longitude;
+    request.fileName = fileName;
+    request.success = false;
+    request.notModified = false;
+    switch (type) {
+        case DataRequest::WEATHER:
+            request.url = getRequestStringWeatherData(latitude, longitude);
+            break;
+        case DataRequest::ALTITUDE:
+            request.url = getRequestStringAltitudeData(latitude, longitude);
+            break;
+        case DataRequest::TLE:
+            request.url = getRequestStringTLEData(fileName);
+            break;
+    }
+    return request;
+}
 
-    // Evaluate data and return result
-    return evaluateTLEData(dataString, numSat);
+bool WebServiceControl::fetchData(DataRequest& request)
+{
+    std::vector< DataRequest > requests(1, request);
+    fetchCoalesced(dataProvider, requests, circuitBreaker);
+    request = requests[0];
+    const bool success = request.success;
+
+    // A replay must behave exactly like the recorded run, so it does not continue with missing data
+    if (!success && replayData) {
+        error("Error in WebServiceControl::fetchData(): No recorded data for %s", request.url.c_str());
+    }
+    return success;
 }
 
-TLEData WebServiceControl::getTLEData(std::string fileName, std::string satName)
+void WebServiceControl::fetchCoalesced(DataProvider* provider, std::vector< DataRequest >& requests,
+                                       CircuitBreakerDataProvider* budget)
 {
-    // Fetch TLE data file
-    std::string dataString = requestTLEData(fileName);
+    std::vector< std::shared_ptr< inFlightFetch > > fetches(requests.size());
+    std::vector< std::size_t > ownIndices;
+    std::vector< DataRequest > ownRequests;
+    std::vector< std::string > ownKeys;
+    std::vector< bool > joined(requests.size(), false);
+
+    // A provider which does not share responses only joins (and is joined by) its own requests
+    std::string providerKey;
+    if (!provider->sharesResponses()) {
+        std::ostringstream providerStream;
+        providerStream << static_cast< const void* >(provider);
+        providerKey = providerStream.str();
+    }
 
-    // Evaluate data and return result
-    return evaluateTLEData(dataString, satName);
+    // Join the fetches which are already in flight, all other requests are sent by this caller
+    {
+        std::lock_guard< std::mutex > lock(inFlightMutex);
+        for (std::size_t i = 0; i < requests.size(); i++) {
+            // Conditional requests only share the response with requests for the same version
+            const std::string key = providerKey + "\n" + requests[i].url + "\n" + requests[i].etag + "\n"
+                    + requests[i].lastModified;
+            std::shared_ptr< inFlightFetch >& inFlight = inFlightFetches[key];
+            if (inFlight) {
+                joined[i] = true;
+                numCoalesced++;
+            } else {
+                inFlight = std::make_shared< inFlightFetch >();
+                inFlight->done = false;
+                inFlight->response.success = false;
+                inFlight->response.notModified = false;
+                ownIndices.push_back(i);
+                ownRequests.push_back(requests[i]);
+                ownKeys.push_back(key);
+            }
+            fetches[i] = inFlight;
+        }
+    }
+
+    if (!ownRequests.empty()) {
+        provider->fetchAll(ownRequests);
+    }
+
+    // Publish the own results before waiting for other callers, so two callers never wait for each other
+    std::unique_lock< std::mutex > lock(inFlightMutex);
+    for (std::size_t j = 0; j < ownRequests.size(); j++) {
+        inFlightFetch& inFlight = *fetches[ownIndices[j]];
+        inFlight.done = true;
+        inFlight.response = ownRequests[j];
+        inFlightFetches.erase(ownKeys[j]);
+        requests[ownIndices[j]] = ownRequests[j];
+    }
+    if (!ownRequests.empty()) {
+        inFlightCondition.notify_all();
+    }
+
+    const double start = DataProvider::getWallClock();
+    bool waited = false;
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        if (!joined[i]) {
+            continue;
+        }
+        const std::shared_ptr< inFlightFetch > inFlight = fetches[i];
+        if (!inFlight->done) {
+            waited = true;
+            const double remaining = (budget != nullptr)
+                    ? budget->getRemainingBudget() - (DataProvider::getWallClock() - start)
+                    : std::numeric_limits< double >::infinity();
+            if (remaining == std::numeric_limits< double >::infinity()) {
+                inFlightCondition.wait(lock, [&inFlight]() { return inFlight->done; });
+            } else if (remaining > 0) {
+                inFlightCondition.wait_for(lock, std::chrono::duration< double >(remaining),
+                                           [&inFlight]() { return inFlight->done; });
+            }
+        }
+        if (inFlight->done) {
+            requests[i].success = inFlight->response.success;
+            requests[i].notModified = inFlight->response.notModified;
+            requests[i].result = inFlight->response.result;
+            requests[i].etag = inFlight->response.etag;
+            requests[i].lastModified = inFlight->response.lastModified;
+        } else {
+            requests[i].success = false;
+            requests[i].notModified = false;
+            requests[i].result.clear();
+        }
+    }
+    if (waited && budget != nullptr) {
+        budget->addWaitTime(DataProvider::getWallClock() - start);
+    }
 }
@@ -18,8 +18,21 @@
 
 #include <omnetpp.h>
 
-#include <curl/curl.h>
-#include <curl/easy.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "os3/base/DataProvider.h"
+#include "os3/base/LRUCache.h"
+#include "os3/base/TLECatalog.h"
+
+class cOrbit;
 
 struct WeatherData
 {
@@ -50,13 +63,22 @@ struct TLEData
 // Class: WebServiceControl
 //
 // Pulls data for live weather, TLE and altitude
+// The raw data is taken from a DataProvider (live HTTP, local files, recording or replay of recorded responses)
 //-----------------------------------------------------
 class WebServiceControl : public cSimpleModule
 {
 public:
+    WebServiceControl();
+    virtual ~WebServiceControl();
+
     // returns live weather data for initialized region
+    // With a background refresh, registered locations are answered from the latest snapshot without blocking;
+    // other locations are registered for the refresh and fetched once.
     WeatherData getWeatherData(const double& latitude, const double& longitude);
 
+    // Registers a location whose weather data is kept up to date by the background refresh (if enabled)
+    void registerWeatherLocation(const double& latitude, const double& longitude);
+
     // returns altitude data
     double getAltitudeData(const double& latitude, const double& longitude);
 
@@ -77,14 +99,42 @@ public:
     // satName: name of the satellite for which TLE data is requested
     TLEData getTLEData(std::string fileName, std::string satName);
 
-    // checks if an url exists
+    /**
+     * Returns the orbit of a satellite of a TLE file (see getTLEData()). The orbits are kept per file; when a new
+     * version of the file is fetched, only the orbits whose element sets changed are initialized again. Callers
+     * should request the orbit again after the TLE file may have been refreshed (e.g., after the cache TTL).
+     * Note: this is an API for external callers only; the satellites of the simulation (Norad, ConstellationManager)
+     * take their orbits from TLECatalogControl, so tleOrbitsReinitialized stays 0 unless another module uses it.
+     * @param fileName File name of the TLE file
+     * @param satName Name of the satellite
+     */
+    std::shared_ptr< const cOrbit > getOrbit(std::string fileName, std::string satName);
+
+    // checks if an url exists (the check waits at most 5 s and is charged to the latency budget)
     bool urlExist(std::string url);
 
+    /**
+     * Fetches weather data, altitude data and TLE files in one batch (concurrently with the HTTP provider) and stores them in the caches
+     * Entries which are already cached are skipped. Afterwards, the corresponding get methods are answered from the caches
+     * without any network request.
+     * @param locations Coordinates (latitude, longitude) of the ground stations
+     * @param fetchWeather Whether weather data is fetched for the locations
+     * @param fetchAltitude Whether altitude data is fetched for the locations
+     * @param tleFiles File names of the TLE files
+     */
+    void prefetch(const std::vector< std::pair< double, double > >& locations, bool fetchWeather, bool fetchAltitude,
+                  const std::vector< std::string >& tleFiles);
+
+    // Collects the coordinates of all ground stations (LUTMotionMobility and Observer modules) below module
+    static void collectStationLocations(cModule* module, std::vector< std::pair< double, double > >& locations);
+
 protected:
     virtual void initialize();
 
     virtual void handleMessage(cMessage* msg);
 
+    virtual void finish();
+
     // creates the request string for the weatherData request
     std::string getRequestStringWeatherData(const double& latitude, const double& longitude);
 
@@ -94,21 +144,33 @@ protected:
     // creates the request string for the TLE data request
     std::string getRequestStringTLEData(std::string fileName);
 
-    // creates the request for the weatherData
-    std::string requestWeatherData(const double& latitude, const double& longitude);
+    // returns the parsed weather data of a location (from cache or fetched and parsed)
+    WeatherData requestWeatherData(const double& latitude, const double& longitude);
 
-    // creates the request for the altitude data
-    double requestAltitudeData(const double& latitude, const double& longitude);
+    /**
+     * Creates the request for the altitude data
+     * @param altitude Output, fetched altitude
+     * @return false if the request failed or the answer is empty or invalid (-9999)
+     */
+    bool requestAltitudeData(const double& latitude, const double& longitude, double& altitude);
 
     /**
      * Creation of request for TLE data
-     * This method creates the request for the TLE data. If an entry for requested TLE file is saved in tleCache, the saved data string is returned instead of
-     * another request to the website is taken.
-     * If the datastring is not in cache, data is loaded from the website and saved in cache in order to reduce latency for further requests.
+     * This method creates the request for the TLE data. If the parsed TLE file with name fileName is saved in tleCache, it is returned
+     * instead of another request to the website is taken.
+     * If the file is not in cache, data is loaded from the website, parsed and saved in cache in order to reduce latency for further requests.
      * @param fileName file name of the TLE file located at www.celestrak.com/NORAD/elements/xxx.txt
-     * @return String containing the data of the TLE file with actual TLE data taken from www.celestrak.com
+     * @return Parsed TLE file with actual TLE data taken from www.celestrak.com
      */
-    std::string requestTLEData(std::string fileName);
+    std::shared_ptr< const TLECatalog > requestTLEData(std::string fileName);
+
+    /**
+     * Parse TLE file
+     * This method indexes a TLE file in a single pass (records of three lines: name, line 1, line 2).
+     * @param dataString String containing the data of a TLE file from www.celestrak.com/NORAD/elements/xxx.txt
+     * @return Parsed TLE file
+     */
+    static std::shared_ptr< const TLECatalog > parseTLEFile(const std::string& dataString);
 
     /**
      * Evaluate weather data
@@ -116,34 +178,180 @@ protected:
      * @param dataString String containing the data of a .csv weather file from www.worldweatheronline.com
      * @return Weather data for requested region
      */
-    WeatherData evaluateWeatherInformation(std::string dataString);
+    static WeatherData evaluateWeatherInformation(std::string dataString);
 
     /**
      * Evaluate TLE data
-     * This method evaluates the fetched TLE data and parse the TLE data of the numSat satellite into a TLEData struct.
-     * @param dataString String containing the data of a TLE file from www.celestrak.com/NORAD/elements/xxx.txt
+     * This method returns the TLE data of the numSat satellite of a parsed TLE file.
+     * @param tleFile Parsed TLE file
      * @return TLEData for requested satellite
      */
-    TLEData evaluateTLEData(std::string dataString, unsigned int numSat);
+    TLEData evaluateTLEData(const TLECatalog& tleFile, unsigned int numSat);
 
     /**
      * Evaluate TLE data
-     * This method evaluates the fetched TLE data and parse the TLE data of the satellite with name satName into a TLEData struct.
-     * @param dataString String containing the data of a TLE file from www.celestrak.com/NORAD/elements/xxx.txt
+     * This method returns the TLE data of the satellite with name satName of a parsed TLE file.
+     * If there is no satellite with exactly this name, the first satellite whose name contains satName is returned.
+     * @param tleFile Parsed TLE file
      * @return TLEData for requested satellite
      */
-    TLEData evaluateTLEData(std::string dataString, std::string satName);
+    TLEData evaluateTLEData(const TLECatalog& tleFile, std::string satName);
+
+    // Creates a request (including the URL of the web service); latitude and longitude are ignored for TLE requests
+    DataRequest createRequest(DataRequest::Type type, const double& latitude, const double& longitude,
+                              const std::string& fileName = "");
+
+    /**
+     * Fetches a request from the data provider
+     * @return Whether the request succeeded (in replay mode, missing data is an error)
+     */
+    bool fetchData(DataRequest& request);
+
+    /**
+     * Fetches requests such that identical requests in flight at the same time (e.g., from the simulation and the
+     * refresh thread, or twice in one batch) are sent only once; the other callers wait for the result. Requests of
+     * a provider which does not share responses (e.g., a recording) are only coalesced with its own requests.
+     * @param provider Provider which sends the requests of this caller
+     * @param requests Requests; result and success are set for each request
+     * @param budget Circuit breaker whose latency budget limits and is charged with the time spent waiting for
+     *               requests of other callers, nullptr = unlimited
+     */
+    void fetchCoalesced(DataProvider* provider, std::vector< DataRequest >& requests,
+                        CircuitBreakerDataProvider* budget);
+
+    /**
+     * Maps a coordinate onto the nearest point of a grid, such that nearby queries share one cache entry
+     * @param latitude Latitude in degrees
+     * @param longitude Longitude in degrees
+     * @param resolution Grid spacing in degrees, 0 = coordinates are used exactly
+     * @return Grid point (latitude, longitude)
+     */
+    static std::pair< double, double > quantizeLocation(const double& latitude, const double& longitude,
+                                                       const double& resolution);
+
+    /**
+     * Determines the altitude grid points needed for a location and their weights. Without interpolation this is the
+     * nearest grid point, with interpolation the (up to four) corners of the surrounding grid cell (bilinear weights).
+     */
+    void getAltitudeGridPoints(const double& latitude, const double& longitude,
+                               std::vector< std::pair< double, double > >& points, std::vector< double >& weights) const;
+
+    // Returns the altitude of a single grid point (cached or fetched; if it can not be fetched, a stale cached value
+    // or defaultAltitude)
+    double getGridAltitude(const std::pair< double, double >& point);
+
+    // Returns the current time of the clock the cache time-to-live refers to (simulation or wall clock time) in s
+    double getCacheTime() const;
+
+    // Weather data of the registered locations at one point in time; published snapshots are never modified
+    typedef std::unordered_map< std::pair< double, double >, WeatherData, coordinateHash > WeatherSnapshot;
+
+    /**
+     * Looks up a grid point in the current weather snapshot (simulation thread only). The lookup is lock-free:
+     * the reader only flags that it accesses the snapshot, and the refresh thread frees a replaced snapshot
+     * only when no read is in progress (so at most two snapshots exist at a time).
+     * @return false if the grid point is not contained in the snapshot
+     */
+    bool readWeatherSnapshot(const std::pair< double, double >& gridPoint, WeatherData& weatherData);
+
+    // Main loop of the background refresh thread
+    void refreshWeather();
+
+    // Stops and joins the background refresh thread
+    void stopWeatherRefresh();
+
+    // Parses fetched data and saves it in the caches (least recently used entries are evicted if a cache is full)
+    void cacheWeatherData(const double& latitude, const double& longitude, const std::string& data);
+    void cacheAltitudeData(const double& latitude, const double& longitude, const double& altitude);
+
+    // Orbits of the satellites of a TLE file by catalog number
+    typedef std::map< long, std::shared_ptr< const cOrbit > > OrbitMap;
+
+    // Last fetched version of a TLE file with the validators of the web service
+    struct tleVersion
+    {
+        std::string etag;
+        std::string lastModified;
+        std::shared_ptr< const TLECatalog > catalog;
+    };
+
+    /**
+     * Processes the answer to a TLE request and saves the current version in the TLE cache: an unchanged file
+     * ("304 Not Modified") keeps its parsed version, a changed file is parsed, compared with the last version
+     * (see updateOrbits()) and stored.
+     * @return Current version of the TLE file
+     */
+    std::shared_ptr< const TLECatalog > cacheTLEData(const DataRequest& request);
+
+    // Sets the validators of the last version of a TLE file in a request, so an unchanged file is not sent again
+    void addTLEValidators(DataRequest& request);
+
+    // Returns the last version of a TLE file (read from the TLE store on first use), nullptr if there is none
+    tleVersion* getTLEVersion(const std::string& fileName);
+
+    // Writes a version of a TLE file and its validators to the TLE store
+    void storeTLEVersion(const std::string& fileName, const tleVersion& version, const std::string& data);
+
+    // Initializes the orbits of the satellites whose element sets differ between two versions of a TLE file again
+    void updateOrbits(const std::string& fileName, const TLECatalog& previous, const TLECatalog& current);
 
 private:
     //Variables
     std::string weatherApiKey;
     std::string altitudeUsername;
-    unsigned int altitudeCacheThreshold;
-    unsigned int tleCacheThreshold;
-    unsigned int weatherCacheThreshold;
-    std::map< std::pair< double, double >, double > altitudeCache;
-    std::map< std::string, std::string > tleCache;
-    std::map< std::pair< double, double >, std::string > weatherCache;
+    std::string weatherServiceUrl;
+    std::string altitudeServiceUrl;
+    std::string tleServiceUrl;
+    bool curlInitialized;                // curl_global_init() was called by initialize()
+    DataProvider* dataProvider;
+    HttpDataProvider* httpProvider;      // HTTP backend of dataProvider, nullptr if the network is not used
+    CircuitBreakerDataProvider* circuitBreaker;  // guards httpProvider, nullptr if the network is not used
+    bool replayData;                     // data must not be missing (deterministic replay)
+    double defaultAltitude;              // used if no altitude can be fetched or is cached
+    unsigned long numFallbacks;          // answers from stale cache entries or default values
+    double weatherGridResolution;        // in degrees, 0 = exact coordinates
+    double altitudeGridResolution;       // in degrees, 0 = exact coordinates
+    bool interpolateAltitude;            // bilinear interpolation between the altitude grid points
+    bool cacheWallClock;                 // true: time-to-live of the cache entries refers to wall clock time
+    LRUCache< std::pair< double, double >, double, coordinateHash > altitudeCache;
+    LRUCache< std::string, std::shared_ptr< const TLECatalog > > tleCache;
+    LRUCache< std::pair< double, double >, WeatherData, coordinateHash > weatherCache;
+
+    // Versions of the TLE files for conditional requests, and the orbits built from them (by catalog number)
+    std::string tleStoreDirectory;                                // persistent store of the versions, "" = memory only
+    std::map< std::string, tleVersion > tleVersions;
+    std::map< std::string, OrbitMap > tleOrbits;
+    unsigned long numTLENotModified;
+    unsigned long numElementSetsChanged;
+    unsigned long numOrbitsReinitialized;
+
+    // Background refresh of the weather data (the refresh thread uses its own data provider)
+    double weatherRefreshInterval;                                // in s (wall clock), 0 = disabled
+    DataProvider* refreshProvider;
+    std::thread refreshThread;
+    std::mutex refreshMutex;                                      // protects refreshLocations and stopRefresh
+    std::condition_variable refreshCondition;
+    std::vector< std::pair< double, double > > refreshLocations;  // registered grid points
+    bool refreshLocationsChanged;
+    bool stopRefresh;
+    std::set< std::pair< double, double > > registeredLocations;  // registered grid points (simulation thread)
+    std::atomic< const WeatherSnapshot* > weatherSnapshot;
+    std::atomic< bool > snapshotReaderActive;
+    std::atomic< unsigned long > numWeatherRefreshes;
+    unsigned long numSnapshotHits;
+
+    // Fetch in flight, shared by all callers which request the same data
+    struct inFlightFetch
+    {
+        bool done;
+        DataRequest response;
+    };
+
+    // Requests in flight by their provider (if it does not share responses), URL and validators (protected by inFlightMutex)
+    std::mutex inFlightMutex;
+    std::condition_variable inFlightCondition;
+    std::unordered_map< std::string, std::shared_ptr< inFlightFetch > > inFlightFetches;
+    std::atomic< unsigned long > numCoalesced;
 };
 
 #endif
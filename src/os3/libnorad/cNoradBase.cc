@@ -35,35 +35,71 @@
 #include "os3/libnorad/cJulian.h"
 
 #include <cmath>
+#include <cstddef>
+
+// Members which are saved by saveState() (order defines the layout of the state)
+double cNoradBase::* const cNoradBase::s_stateMembers[] = {
+   &cNoradBase::m_satInc,  &cNoradBase::m_satEcc,
+   &cNoradBase::m_cosio,   &cNoradBase::m_theta2,  &cNoradBase::m_x3thm1,  &cNoradBase::m_eosq,
+   &cNoradBase::m_betao2,  &cNoradBase::m_betao,   &cNoradBase::m_aodp,    &cNoradBase::m_xnodp,
+   &cNoradBase::m_s4,      &cNoradBase::m_qoms24,  &cNoradBase::m_perigee, &cNoradBase::m_tsi,
+   &cNoradBase::m_eta,     &cNoradBase::m_etasq,   &cNoradBase::m_eeta,    &cNoradBase::m_coef,
+   &cNoradBase::m_coef1,   &cNoradBase::m_c1,      &cNoradBase::m_c2,      &cNoradBase::m_c3,
+   &cNoradBase::m_c4,      &cNoradBase::m_sinio,   &cNoradBase::m_a3ovk2,  &cNoradBase::m_x1mth2,
+   &cNoradBase::m_xmdot,   &cNoradBase::m_omgdot,  &cNoradBase::m_xhdot1,  &cNoradBase::m_xnodot,
+   &cNoradBase::m_xnodcf,  &cNoradBase::m_t2cof,   &cNoradBase::m_xlcof,   &cNoradBase::m_aycof,
+   &cNoradBase::m_x7thm1
+};
+
+cNoradBase::cNoradBase(const cOrbit& orbit)
+{
+   InitializeElements(orbit);
+   Initialize(orbit);
+}
 
-cNoradBase::cNoradBase(const cOrbit& orbit) :
-   m_Orbit(orbit)
+cNoradBase::cNoradBase(const cOrbit& orbit, const double*& state)
 {
-   Initialize();
+   InitializeElements(orbit);
+   for (std::size_t i = 0; i < sizeof(s_stateMembers) / sizeof(s_stateMembers[0]); i++)
+      this->*s_stateMembers[i] = *state++;
 }
 
 cNoradBase::~cNoradBase()
 {}
 
-cNoradBase& cNoradBase::operator=(const cNoradBase& b)
+//-----------------------------------------------------
+// saveState()
+// Appends the time-independent orbit constants calculated by Initialize()
+//-----------------------------------------------------
+void cNoradBase::saveState(std::vector<double>& state) const
 {
-   // m_Orbit is a "const" member var, so cast away its
-   // "const-ness" in order to complete the assigment.
-   *(const_cast<cOrbit*>(&m_Orbit)) = b.m_Orbit;
+   for (std::size_t i = 0; i < sizeof(s_stateMembers) / sizeof(s_stateMembers[0]); i++)
+      state.push_back(this->*s_stateMembers[i]);
+}
 
-   return *this;
+//////////////////////////////////////////////////////////////////////////////
+// InitializeElements()
+// Copies the elements which are needed during propagation from the orbit,
+// such that getPosition() does not access the orbit.
+void cNoradBase::InitializeElements(const cOrbit& orbit)
+{
+   m_jdEpoch    = orbit.Epoch();
+   m_raan       = orbit.RAAN();
+   m_argPerigee = orbit.ArgPerigee();
+   m_mnAnomaly  = orbit.mnAnomaly();
+   m_bstar      = orbit.BStar();
 }
 
 //////////////////////////////////////////////////////////////////////////////
 // Initialize()
 // Perform the initialization of member variables, specifically the variables
 // used by derived-class objects to calculate ECI coordinates.
-void cNoradBase::Initialize()
+void cNoradBase::Initialize(const cOrbit& orbit)
 {
    // Initialize any variables which are time-independent when
    // calculating the ECI coordinates of the satellite.
-   m_satInc = m_Orbit.Inclination();
-   m_satEcc = m_Orbit.Eccentricity();
+   m_satInc = orbit.Inclination();
+   m_satEcc = orbit.Eccentricity();
 
    m_cosio  = std::cos(m_satInc);
    m_theta2 = m_cosio * m_cosio;
@@ -73,8 +109,8 @@ void cNoradBase::Initialize()
    m_betao  = std::sqrt(m_betao2);
 
    // The "recovered" semi-minor axis and mean motion.
-   m_aodp  = m_Orbit.SemiMinor();
-   m_xnodp = m_Orbit.mnMotionRec();
+   m_aodp  = orbit.SemiMinor();
+   m_xnodp = orbit.mnMotionRec();
 
    // For perigee below 156 km, the values of S and QOMS2T are altered.
    m_perigee = XKMPER_WGS72 * (m_aodp * (1.0 - m_satEcc) - AE);
@@ -110,7 +146,7 @@ void cNoradBase::Initialize()
                      0.75 * CK2 * m_tsi / psisq * m_x3thm1 *
                      (8.0 + 3.0 * m_etasq * (8.0 + m_etasq)));
 
-   m_c1    = m_Orbit.BStar() * c2;
+   m_c1    = m_bstar * c2;
    m_sinio = std::sin(m_satInc);
 
    const double a3ovk2 = -XJ3 / CK2 * std::pow(AE,3.0);
@@ -124,7 +160,7 @@ void cNoradBase::Initialize()
               (-3.0 * m_x3thm1 * (1.0 - 2.0 * m_eeta + m_etasq * (1.5 - 0.5 * m_eeta)) +
               0.75 * m_x1mth2 *
               (2.0 * m_etasq - m_eeta * (1.0 + m_etasq)) *
-              std::cos(2.0 * m_Orbit.ArgPerigee())));
+              std::cos(2.0 * m_argPerigee)));
 
    const double theta4 = m_theta2 * m_theta2;
    const double temp1  = 3.0 * CK2 * pinvsq * m_xnodp;
@@ -271,7 +307,7 @@ bool cNoradBase::FinalPosition(double incl, double  omega,
 
    cVector vecVel(xdot, ydot, zdot);
 
-   cJulian gmt = m_Orbit.Epoch();
+   cJulian gmt = m_jdEpoch;
    gmt.addMin(tsince);
 
    eci = cEci(vecPos, vecVel, gmt);
@@ -9,6 +9,11 @@
 #ifndef __LIBNORAD_cNoradBase_H__
 #define __LIBNORAD_cNoradBase_H__
 
+#include <cstddef>
+#include <vector>
+
+#include "os3/libnorad/cJulian.h"
+
 class cEci;
 class cOrbit;
 
@@ -20,15 +25,38 @@ public:
 
    virtual bool getPosition(double tsince, cEci &eci) = 0;
 
+   // Appends the initialized model constants to state (see restoring constructor)
+   virtual void saveState(std::vector<double>& state) const;
+
+   // Copy constructs the model into buffer (at least getSize() bytes, suitably
+   // aligned) and returns it. The orbit is only read during the construction
+   // of a model, the copy therefore propagates without it; it has to be
+   // destroyed explicitly by calling its destructor.
+   virtual cNoradBase* clone(void* buffer) const = 0;
+
+   // Size of the model object in bytes
+   virtual std::size_t getSize() const = 0;
+
 protected:
-   cNoradBase& operator=(const cNoradBase&);
+   // Restores the model constants saved by saveState() instead of calculating
+   // them; state is advanced behind the constants of this class.
+   cNoradBase(const cOrbit&, const double*& state);
+
+   // The model holds no reference to the orbit, so copies are independent of it
+   cNoradBase(const cNoradBase&) = default;
 
-   void Initialize();
+   void Initialize(const cOrbit&);
+   void InitializeElements(const cOrbit&);
    bool FinalPosition(double  incl, double omega,  double     e,
                       double     a, double    xl,  double xnode,
                       double    xn, double tsince, cEci &eci);
 
-   const cOrbit& m_Orbit;
+   // Elements read during propagation, copied from the orbit
+   cJulian m_jdEpoch;
+   double m_raan;
+   double m_argPerigee;
+   double m_mnAnomaly;
+   double m_bstar;
 
    // Orbital parameter variables which need only be calculated one
    // time for a given orbit (ECI position time-independent).
@@ -44,6 +72,11 @@ protected:
    double m_xmdot;   double m_omgdot;  double m_xhdot1;  double m_xnodot;
    double m_xnodcf;  double m_t2cof;   double m_xlcof;   double m_aycof;
    double m_x7thm1;
+
+private:
+   cNoradBase& operator=(const cNoradBase&);
+
+   static double cNoradBase::* const s_stateMembers[];
 };
 
 #endif
@@ -13,6 +13,8 @@
 #include "os3/libnorad/cVector.h"
 
 #include <cmath>
+#include <cstddef>
+#include <new>
 
 const double zns    =  1.19459E-5;     const double c1ss   =  2.9864797E-6;
 const double zes    =  0.01675;        const double znl    =  1.5835218E-4;
@@ -27,11 +29,39 @@ const double root22 =  1.7891679E-6;   const double root32 =  3.7393792E-7;
 const double root44 =  7.3636953E-9;   const double root52 =  1.1428639E-7;
 const double root54 =  2.1765803E-9;   const double thdt   =  4.3752691E-3;
 
+// Members which are saved by saveState() in addition to the base class members
+// (the flags dp_iresfl and dp_isynfl are saved separately, the scratch variables of
+// DeepSecular() are not saved)
+double cNoradSDP4::* const cNoradSDP4::s_stateMembers[] = {
+   &cNoradSDP4::m_sing, &cNoradSDP4::m_cosg, &cNoradSDP4::eqsq, &cNoradSDP4::siniq,
+   &cNoradSDP4::cosiq, &cNoradSDP4::rteqsq, &cNoradSDP4::ao, &cNoradSDP4::cosq2,
+   &cNoradSDP4::sinomo, &cNoradSDP4::cosomo, &cNoradSDP4::bsq, &cNoradSDP4::xlldot,
+   &cNoradSDP4::omgdt, &cNoradSDP4::xnodot, &cNoradSDP4::dp_e3, &cNoradSDP4::dp_ee2,
+   &cNoradSDP4::dp_savtsn, &cNoradSDP4::dp_se2, &cNoradSDP4::dp_se3, &cNoradSDP4::dp_sgh2,
+   &cNoradSDP4::dp_sgh3, &cNoradSDP4::dp_sgh4, &cNoradSDP4::dp_sghs, &cNoradSDP4::dp_sh2,
+   &cNoradSDP4::dp_sh3, &cNoradSDP4::dp_si2, &cNoradSDP4::dp_si3, &cNoradSDP4::dp_sl2,
+   &cNoradSDP4::dp_sl3, &cNoradSDP4::dp_sl4, &cNoradSDP4::dp_xgh2, &cNoradSDP4::dp_xgh3,
+   &cNoradSDP4::dp_xgh4, &cNoradSDP4::dp_xh2, &cNoradSDP4::dp_xh3, &cNoradSDP4::dp_xi2,
+   &cNoradSDP4::dp_xi3, &cNoradSDP4::dp_xl2, &cNoradSDP4::dp_xl3, &cNoradSDP4::dp_xl4,
+   &cNoradSDP4::dp_xqncl, &cNoradSDP4::dp_zmol, &cNoradSDP4::dp_zmos, &cNoradSDP4::dp_atime,
+   &cNoradSDP4::dp_d2201, &cNoradSDP4::dp_d2211, &cNoradSDP4::dp_d3210, &cNoradSDP4::dp_d3222,
+   &cNoradSDP4::dp_d4410, &cNoradSDP4::dp_d4422, &cNoradSDP4::dp_d5220, &cNoradSDP4::dp_d5232,
+   &cNoradSDP4::dp_d5421, &cNoradSDP4::dp_d5433, &cNoradSDP4::dp_del1, &cNoradSDP4::dp_del2,
+   &cNoradSDP4::dp_del3, &cNoradSDP4::dp_fasx2, &cNoradSDP4::dp_fasx4, &cNoradSDP4::dp_fasx6,
+   &cNoradSDP4::dp_omegaq, &cNoradSDP4::dp_sse, &cNoradSDP4::dp_ssg, &cNoradSDP4::dp_ssh,
+   &cNoradSDP4::dp_ssi, &cNoradSDP4::dp_ssl, &cNoradSDP4::dp_step2, &cNoradSDP4::dp_stepn,
+   &cNoradSDP4::dp_stepp, &cNoradSDP4::dp_thgr, &cNoradSDP4::dp_xfact, &cNoradSDP4::dp_xlamo,
+   &cNoradSDP4::dp_xli, &cNoradSDP4::dp_xni, &cNoradSDP4::dpi_c, &cNoradSDP4::dpi_ctem,
+   &cNoradSDP4::dpi_day, &cNoradSDP4::dpi_gam, &cNoradSDP4::dpi_stem, &cNoradSDP4::dpi_xnodce,
+   &cNoradSDP4::dpi_zcosgl, &cNoradSDP4::dpi_zcoshl, &cNoradSDP4::dpi_zcosil, &cNoradSDP4::dpi_zsingl,
+   &cNoradSDP4::dpi_zsinhl, &cNoradSDP4::dpi_zsinil, &cNoradSDP4::dpi_zx, &cNoradSDP4::dpi_zy
+};
+
 cNoradSDP4::cNoradSDP4(const cOrbit& orbit) :
    cNoradBase(orbit)
 {
-   m_sing = std::sin(m_Orbit.ArgPerigee());
-   m_cosg = std::cos(m_Orbit.ArgPerigee());
+   m_sing = std::sin(m_argPerigee);
+   m_cosg = std::cos(m_argPerigee);
 
    dp_savtsn = 0.0;
    dp_zmos = 0.0;
@@ -98,11 +128,43 @@ cNoradSDP4::cNoradSDP4(const cOrbit& orbit) :
    dp_iresfl = false;
    dp_isynfl = false;
 
+   dpi_day = 0.0;
+
+   // The deep space terms only depend on the elements, so they are initialized once
+   // (and not on every call of getPosition()). getPosition() restarts the resonance
+   // integrator at epoch on every call.
+   DeepInit(&m_eosq, &m_sinio, &m_cosio,  &m_betao, &m_aodp,   &m_theta2,
+            &m_sing, &m_cosg,  &m_betao2, &m_xmdot, &m_omgdot, &m_xnodot);
+}
+
+cNoradSDP4::cNoradSDP4(const cOrbit& orbit, const double*& state) :
+   cNoradBase(orbit, state)
+{
+   for (std::size_t i = 0; i < sizeof(s_stateMembers) / sizeof(s_stateMembers[0]); i++)
+      this->*s_stateMembers[i] = *state++;
+
+   dp_iresfl = (*state++ != 0.0);
+   dp_isynfl = (*state++ != 0.0);
 }
 
 cNoradSDP4::~cNoradSDP4()
 {}
 
+void cNoradSDP4::saveState(std::vector<double>& state) const
+{
+   cNoradBase::saveState(state);
+   for (std::size_t i = 0; i < sizeof(s_stateMembers) / sizeof(s_stateMembers[0]); i++)
+      state.push_back(this->*s_stateMembers[i]);
+
+   state.push_back(dp_iresfl ? 1.0 : 0.0);
+   state.push_back(dp_isynfl ? 1.0 : 0.0);
+}
+
+cNoradBase* cNoradSDP4::clone(void* buffer) const
+{
+   return new (buffer) cNoradSDP4(*this);
+}
+
 bool cNoradSDP4::DeepInit(double* eosq,  double* sinio,  double* cosio,
                           double* betao, double* aodp,   double* theta2,
                           double* sing,  double* cosg,   double* betao2,
@@ -122,21 +184,21 @@ bool cNoradSDP4::DeepInit(double* eosq,  double* sinio,  double* cosio,
    xnodot = *xnodott;
 
    // Deep space initialization
-   cJulian jd = m_Orbit.Epoch();
+   cJulian jd = m_jdEpoch;
 
    dp_thgr = jd.toGMST();
 
-   const double eq   = m_Orbit.Eccentricity();
+   const double eq   = m_satEcc;
    const double aqnv = 1.0 / ao;
 
-   dp_xqncl = m_Orbit.Inclination();
+   dp_xqncl = m_satInc;
 
-   const double xmao   = m_Orbit.mnAnomaly();
+   const double xmao   = m_mnAnomaly;
    const double xpidot = omgdt + xnodot;
-   const double sinq   = std::sin(m_Orbit.RAAN());
-   const double cosq   = std::cos(m_Orbit.RAAN());
+   const double sinq   = std::sin(m_raan);
+   const double cosq   = std::cos(m_raan);
 
-   dp_omegaq = m_Orbit.ArgPerigee();
+   dp_omegaq = m_argPerigee;
 
    // Initialize lunar solar terms
    const double day = jd.FromJan1_12h_1900();
@@ -387,7 +449,7 @@ bool cNoradSDP4::DeepInit(double* eosq,  double* sinio,  double* cosio,
          temp = 2.0 * temp1 * root54;
          dp_d5421 = temp * f542 * g521;
          dp_d5433 = temp * f543 * g533;
-         dp_xlamo = xmao + m_Orbit.RAAN() + m_Orbit.RAAN() - dp_thgr - dp_thgr;
+         dp_xlamo = xmao + m_raan + m_raan - dp_thgr - dp_thgr;
          bfact = xlldot + xnodot + xnodot - thdt - thdt;
          bfact = bfact + dp_ssl + dp_ssh + dp_ssh;
       }
@@ -409,7 +471,7 @@ bool cNoradSDP4::DeepInit(double* eosq,  double* sinio,  double* cosio,
       dp_fasx2 = 0.13130908;
       dp_fasx4 = 2.8843198;
       dp_fasx6 = 0.37448087;
-      dp_xlamo = xmao + m_Orbit.RAAN() + m_Orbit.ArgPerigee() - dp_thgr;
+      dp_xlamo = xmao + m_raan + m_argPerigee - dp_thgr;
       bfact = xlldot + xpidot - thdt;
       bfact = bfact + dp_ssl + dp_ssg + dp_ssh;
    }
@@ -512,8 +574,8 @@ bool cNoradSDP4::DeepSecular(double* xmdf, double* omgadf, double* xnode,
    xll    = xll + dp_ssl * t;
    omgasm = omgasm + dp_ssg * t;
    xnodes = xnodes + dp_ssh * t;
-   _em    = m_Orbit.Eccentricity() + dp_sse * t;
-   xinc   = m_Orbit.Inclination()  + dp_ssi * t;
+   _em    = m_satEcc + dp_sse * t;
+   xinc   = m_satInc + dp_ssi * t;
 
    if (xinc < 0.0) {
       xinc   = -xinc;
@@ -709,17 +771,19 @@ bool cNoradSDP4::DeepPeriodics(double* e,      double* xincc,
 //-----------------------------------------------------
 bool cNoradSDP4::getPosition(double tsince, cEci& eci)
 {
-   DeepInit(&m_eosq, &m_sinio, &m_cosio,  &m_betao, &m_aodp,   &m_theta2,
-            &m_sing, &m_cosg,  &m_betao2, &m_xmdot, &m_omgdot, &m_xnodot);
+   // Always recalculate the lunar-solar periodics and integrate the resonance terms from
+   // epoch, so the result does not depend on earlier calls
+   dp_savtsn = 1.0e20;
+   dp_atime = 0.0;
 
    // Update for secular gravity and atmospheric drag
-   double xmdf   = m_Orbit.mnAnomaly() + m_xmdot * tsince;
-   double omgadf = m_Orbit.ArgPerigee() + m_omgdot * tsince;
-   double xnoddf = m_Orbit.RAAN() + m_xnodot * tsince;
+   double xmdf   = m_mnAnomaly + m_xmdot * tsince;
+   double omgadf = m_argPerigee + m_omgdot * tsince;
+   double xnoddf = m_raan + m_xnodot * tsince;
    double tsq    = tsince * tsince;
    double xnode  = xnoddf + m_xnodcf * tsq;
    double tempa  = 1.0 - m_c1 * tsince;
-   double tempe  = m_Orbit.BStar() * m_c4 * tsince;
+   double tempe  = m_bstar * m_c4 * tsince;
    double templ  = m_t2cof * tsq;
    double xn     = m_xnodp;
    double em;
@@ -20,8 +20,16 @@ public:
    cNoradSDP4(const cOrbit& orbit);
    virtual ~cNoradSDP4();
 
+   // Restores an orbit model from a saved state (see cNoradBase::saveState())
+   cNoradSDP4(const cOrbit& orbit, const double*& state);
+
    virtual bool getPosition(double tsince, cEci& eci);
 
+   virtual void saveState(std::vector<double>& state) const;
+
+   virtual cNoradBase* clone(void* buffer) const;
+   virtual std::size_t getSize() const { return sizeof(cNoradSDP4); }
+
 protected:
    bool DeepInit(double* eosq,    double* sinio,    double* cosio,  double* m_betao,
                  double* m_aodp,  double* m_theta2, double* m_sing, double* m_cosg,
@@ -74,6 +82,8 @@ protected:
    double dpi_zcosil; double dpi_zsingl; double dpi_zsinhl; double dpi_zsinil;
    double dpi_zx;     double dpi_zy;
 
+private:
+   static double cNoradSDP4::* const s_stateMembers[];
 };
 
 #endif
@@ -10,26 +10,52 @@
 #include "os3/libnorad/cNoradSGP4.h"
 
 #include  <cmath>
+#include  <cstddef>
+#include  <new>
 
 #include "os3/libnorad/cJulian.h"
 #include "os3/libnorad/cOrbit.h"
 #include "os3/libnorad/cVector.h"
 #include "os3/libnorad/ccoord.h"
 
+// Members which are saved by saveState() in addition to the base class members
+double cNoradSGP4::* const cNoradSGP4::s_stateMembers[] = {
+   &cNoradSGP4::m_c5, &cNoradSGP4::m_omgcof, &cNoradSGP4::m_xmcof, &cNoradSGP4::m_delmo, &cNoradSGP4::m_sinmo
+};
+
 cNoradSGP4::cNoradSGP4(const cOrbit& orbit) :
    cNoradBase(orbit)
 {
    m_c5     = 2.0 * m_coef1 * m_aodp * m_betao2 *
               (1.0 + 2.75 * (m_etasq + m_eeta) + m_eeta * m_etasq);
-   m_omgcof = m_Orbit.BStar() * m_c3 * std::cos(m_Orbit.ArgPerigee());
-   m_xmcof  = -TWOTHRD * m_coef * m_Orbit.BStar() * AE / m_eeta;
-   m_delmo  = std::pow(1.0 + m_eta * std::cos(m_Orbit.mnAnomaly()), 3.0);
-   m_sinmo  = std::sin(m_Orbit.mnAnomaly());
+   m_omgcof = m_bstar * m_c3 * std::cos(m_argPerigee);
+   m_xmcof  = -TWOTHRD * m_coef * m_bstar * AE / m_eeta;
+   m_delmo  = std::pow(1.0 + m_eta * std::cos(m_mnAnomaly), 3.0);
+   m_sinmo  = std::sin(m_mnAnomaly);
+}
+
+cNoradSGP4::cNoradSGP4(const cOrbit& orbit, const double*& state) :
+   cNoradBase(orbit, state)
+{
+   for (std::size_t i = 0; i < sizeof(s_stateMembers) / sizeof(s_stateMembers[0]); i++)
+      this->*s_stateMembers[i] = *state++;
 }
 
 cNoradSGP4::~cNoradSGP4()
 {}
 
+void cNoradSGP4::saveState(std::vector<double>& state) const
+{
+   cNoradBase::saveState(state);
+   for (std::size_t i = 0; i < sizeof(s_stateMembers) / sizeof(s_stateMembers[0]); i++)
+      state.push_back(this->*s_stateMembers[i]);
+}
+
+cNoradBase* cNoradSGP4::clone(void* buffer) const
+{
+   return new (buffer) cNoradSGP4(*this);
+}
+
 //-----------------------------------------------------
 // getPosition()
 // This procedure returns the ECI position and velocity for the satellite
@@ -82,15 +108,15 @@ bool cNoradSGP4::getPosition(double tsince, cEci& eci)
    }
 
    // Update for secular gravity and atmospheric drag.
-   const double xmdf   = m_Orbit.mnAnomaly() + m_xmdot * tsince;
-   const double omgadf = m_Orbit.ArgPerigee() + m_omgdot * tsince;
-   const double xnoddf = m_Orbit.RAAN() + m_xnodot * tsince;
+   const double xmdf   = m_mnAnomaly + m_xmdot * tsince;
+   const double omgadf = m_argPerigee + m_omgdot * tsince;
+   const double xnoddf = m_raan + m_xnodot * tsince;
    double omega  = omgadf;
    double xmp    = xmdf;
    const double tsq    = tsince * tsince;
    double xnode  = xnoddf + m_xnodcf * tsq;
    double tempa  = 1.0 - m_c1 * tsince;
-   double tempe  = m_Orbit.BStar() * m_c4 * tsince;
+   double tempe  = m_bstar * m_c4 * tsince;
    double templ  = m_t2cof * tsq;
 
    if (!isimp) {
@@ -105,7 +131,7 @@ bool cNoradSGP4::getPosition(double tsince, cEci& eci)
       double tfour = tsince * tcube;
 
       tempa = tempa - d2 * tsq - d3 * tcube - d4 * tfour;
-      tempe = tempe + m_Orbit.BStar() * m_c5 * (std::sin(xmp) - m_sinmo);
+      tempe = tempe + m_bstar * m_c5 * (std::sin(xmp) - m_sinmo);
       templ = templ + t3cof * tcube + tfour * (t4cof + tsince * t5cof);
    }
 
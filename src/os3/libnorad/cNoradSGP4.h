@@ -20,14 +20,25 @@ public:
    cNoradSGP4(const cOrbit& orbit);
    virtual ~cNoradSGP4();
 
+   // Restores an orbit model from a saved state (see cNoradBase::saveState())
+   cNoradSGP4(const cOrbit& orbit, const double*& state);
+
    virtual bool getPosition(double tsince, cEci& eci);
 
+   virtual void saveState(std::vector<double>& state) const;
+
+   virtual cNoradBase* clone(void* buffer) const;
+   virtual std::size_t getSize() const { return sizeof(cNoradSGP4); }
+
 protected:
    double m_c5;
    double m_omgcof;
    double m_xmcof;
    double m_delmo;
    double m_sinmo;
+
+private:
+   static double cNoradSGP4::* const s_stateMembers[];
 };
 
 #endif
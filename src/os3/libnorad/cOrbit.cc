@@ -24,16 +24,7 @@ cOrbit::cOrbit(const cTle &tle) :
    m_pNoradModel(NULL)
 {
    m_tle.Initialize();
-
-   int epochYear = static_cast<int>(m_tle.getField(cTle::FLD_EPOCHYEAR));
-   const double epochDay = m_tle.getField(cTle::FLD_EPOCHDAY );
-
-   if (epochYear < 57)
-      epochYear += 2000;
-   else
-      epochYear += 1900;
-
-   m_jdEpoch = cJulian(epochYear, epochDay);
+   InitializeEpoch();
 
    m_secPeriod = -1.0;
 
@@ -69,11 +60,70 @@ cOrbit::cOrbit(const cTle &tle) :
    }
 }
 
+cOrbit::cOrbit(const cTle& tle, const double*& state) :
+   m_tle(tle),
+   m_pNoradModel(NULL)
+{
+   m_tle.Initialize();
+   InitializeEpoch();
+
+   m_secPeriod = -1.0;
+
+   const bool deepSpace  = (*state++ != 0.0);
+   m_aeAxisSemiMinorRec  = *state++;
+   m_aeAxisSemiMajorRec  = *state++;
+   m_mnMotionRec         = *state++;
+   m_kmPerigeeRec        = *state++;
+   m_kmApogeeRec         = *state++;
+
+   if (deepSpace) {
+      m_pNoradModel = new cNoradSDP4(*this, state);
+   } else {
+      m_pNoradModel = new cNoradSGP4(*this, state);
+   }
+}
+
 cOrbit::~cOrbit()
 {
    delete m_pNoradModel;
 }
 
+void cOrbit::InitializeEpoch()
+{
+   int epochYear = static_cast<int>(m_tle.getField(cTle::FLD_EPOCHYEAR));
+   const double epochDay = m_tle.getField(cTle::FLD_EPOCHDAY );
+
+   if (epochYear < 57)
+      epochYear += 2000;
+   else
+      epochYear += 1900;
+
+   m_jdEpoch = cJulian(epochYear, epochDay);
+}
+
+//-----------------------------------------------------
+// saveState()
+// The layout is: model type (1 = SDP4), recovered elements, model constants
+//-----------------------------------------------------
+void cOrbit::saveState(std::vector<double>& state) const
+{
+   state.push_back(dynamic_cast<const cNoradSDP4*>(m_pNoradModel) != NULL ? 1.0 : 0.0);
+   state.push_back(m_aeAxisSemiMinorRec);
+   state.push_back(m_aeAxisSemiMajorRec);
+   state.push_back(m_mnMotionRec);
+   state.push_back(m_kmPerigeeRec);
+   state.push_back(m_kmApogeeRec);
+   m_pNoradModel->saveState(state);
+}
+
+//-----------------------------------------------------
+// getMemoryUsage()
+//-----------------------------------------------------
+std::size_t cOrbit::getMemoryUsage() const
+{
+   return sizeof(cOrbit) - sizeof(cTle) + m_tle.getMemoryUsage() + m_pNoradModel->getSize();
+}
+
 //-----------------------------------------------------
 // Return the period in seconds
 //-----------------------------------------------------
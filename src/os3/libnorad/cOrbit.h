@@ -12,6 +12,9 @@
 #ifndef __LIBNORAD_cOrbit_H__
 #define __LIBNORAD_cOrbit_H__
 
+#include <cstddef>
+#include <vector>
+
 #include "os3/libnorad/cTLE.h"
 #include "os3/libnorad/cJulian.h"
 
@@ -24,11 +27,27 @@ class cOrbit
 {
 public:
    cOrbit(const cTle& tle);
+
+   // Restores an orbit from a state saved by saveState() instead of initializing
+   // the orbit model. tle must be the element set the state was created from;
+   // state is advanced behind the restored values.
+   cOrbit(const cTle& tle, const double*& state);
+
    virtual ~cOrbit();
 
+   // Appends the recovered elements and the initialized model constants to state
+   void saveState(std::vector<double>& state) const;
+
    // Return satellite ECI data at given minutes since element's epoch.
    bool getPosition(double tsince, cEci* pEci) const;
 
+   // The orbit model (e.g., to clone it, see cNoradBase::clone())
+   const cNoradBase& getModel() const { return *m_pNoradModel; }
+
+   // Approximate memory used by the orbit including the element set and
+   // the orbit model, in bytes
+   std::size_t getMemoryUsage() const;
+
    double Inclination()  const { return radGet(cTle::FLD_I);                 }
    double Eccentricity() const { return m_tle.getField(cTle::FLD_E);         }
    double RAAN()         const { return radGet(cTle::FLD_RAAN);              }
@@ -56,6 +75,9 @@ public:
    double Period()  const;                               // period in seconds
 
 protected:
+   // Calculates the epoch from the elements
+   void InitializeEpoch();
+
    double radGet(cTle::eField fld) const
       { return m_tle.getField(fld, cTle::U_RAD); }
 
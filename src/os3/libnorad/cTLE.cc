@@ -111,6 +111,31 @@ double cTle::getField(eField   fld,
    }
 }
 
+//-----------------------------------------------------
+// getMemoryUsage()
+// Strings which fit into the string object itself do not use heap memory;
+// a map node holds its value and the links of the tree (three pointers and
+// the color, counted as a fourth pointer).
+//-----------------------------------------------------
+std::size_t cTle::getMemoryUsage() const
+{
+   const std::size_t localCapacity = std::string().capacity();
+   std::size_t bytes = sizeof(cTle);
+
+   const std::string* strings[] = { &m_strName, &m_strLine1, &m_strLine2 };
+   for (std::size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+      if (strings[i]->capacity() > localCapacity)
+         bytes += strings[i]->capacity() + 1;
+
+   for (int fld = FLD_FIRST; fld < FLD_LAST; fld++)
+      if (m_Field[fld].capacity() > localCapacity)
+         bytes += m_Field[fld].capacity() + 1;
+
+   bytes += m_mapCache.size() * (sizeof(std::pair<const FldKey, double>) + 4 * sizeof(void*));
+
+   return bytes;
+}
+
 //-----------------------------------------------------
 // Convert the given field into the requested units. It is assumed that
 // the value being converted is in the TLE format's "native" form.
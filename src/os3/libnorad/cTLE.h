@@ -10,6 +10,7 @@
 #ifndef __LIBNORAD_cTle_H__
 #define __LIBNORAD_cTle_H__
 
+#include <cstddef>
 #include <string>
 #include <map>
 
@@ -77,6 +78,10 @@ public:
    std::string getLine1() const                   { return m_strLine1;}
    std::string getLine2() const                   { return m_strLine2;}
 
+   // Approximate memory used by the element set, including the heap
+   // memory of the strings and of the field cache, in bytes
+   std::size_t getMemoryUsage() const;
+
 protected:
    static double ConvertUnits(double val, eField fld, eUnits units);
 
@@ -15,9 +15,12 @@
 
 #include "os3/mobility/Norad.h"
 
+#include <cmath>
 #include <ctime>
-#include <fstream>
 
+#include "os3/base/EphemerisCache.h"
+#include "os3/base/TLECatalog.h"
+#include "os3/base/TLECatalogControl.h"
 #include "os3/libnorad/cTLE.h"
 #include "os3/libnorad/cOrbit.h"
 #include "os3/libnorad/cSite.h"
@@ -29,62 +32,102 @@ Norad::Norad()
     gap = 0.0;
     tle = nullptr;
     orbit = nullptr;
+    ephemerisCache = nullptr;
+    ephemerisHits = 0;
+    ephemerisMisses = 0;
+    interpolation = false;
+    eciTime = -1;
+    previousTime = -1;
+    interpolatedTime = -1;
 }
 
 void Norad::finish()
 {
+    if (ephemerisCache != nullptr) {
+        recordScalar("ephemerisCacheHits", ephemerisHits);
+        recordScalar("ephemerisCacheMisses", ephemerisMisses);
+        if (!ephemerisCache->save()) {
+            EV << "Warning in Norad::finish(): Could not write ephemeris cache "
+               << ephemerisCache->getFileName() << "." << std::endl;
+        }
+        delete ephemerisCache;
+        ephemerisCache = nullptr;
+    }
     delete orbit;
     delete tle;
 }
 
-void Norad::initializeMobility(const simtime_t& targetTime)
+void Norad::initializeMobility(const simtime_t& targetTime, const simtime_t& updateInterval)
 {
     std::string filename = par("TLEfile").stringValue();
 
-    // read file with TLE data
-    std::fstream tleFile;
-    tleFile.open(filename.c_str());
-
-    // Length 100 should be enough since lines are usually 70+'\n' char long
-    char line[100]     = "";
-    char line1tmp[100] = "";
-    char line2tmp[100] = "";
+    // Get the indexed TLE file from the shared catalog module. Networks without CNI_OS3 module load the file themselves.
+    const TLECatalog* catalog = nullptr;
+    TLECatalog localCatalog;
+    bool validateChecksums = true;
+    TLECatalogControl* catalogControl = findCatalogControl();
+    if (catalogControl != nullptr) {
+        catalog = &catalogControl->getCatalog(filename);
+        validateChecksums = catalogControl->getValidateChecksums();
+    } else {
+        if (!localCatalog.load(filename)) {
+            error("Error in Norad::initializeMobility(): Could not open TLE file \"%s\".", filename.c_str());
+        }
+        catalog = &localCatalog;
+    }
 
+    // Select the satellite by catalog number, by name or by the index of the satellite module
     std::string satelliteName = getParentModule()->par("satelliteName").stringValue();
-    std::string line_str;
-    if (satelliteName == "") {
-        int index = getParentModule()->getIndex();
-        int i = 0;
-        do {
-            tleFile.getline(line, 100);
-            if (!tleFile.good()) {
-                EV << "Error in Norad::initializeMobility(): Cannot read further satellites from TLE file!" << std::endl;
-                endSimulation();
-            }
-        } while (i++ < index * 3 && tleFile.good());
-        line_str.append(line);
+    const long catalogNumber = getParentModule()->hasPar("catalogNumber") ? getParentModule()->par("catalogNumber").longValue() : -1;
+    long index;
+    if (catalogNumber >= 0) {
+        index = catalog->findByCatalogNumber(catalogNumber);
+        if (index < 0) {
+            error("Error in Norad::initializeMobility(): Satellite with catalog number %ld not found in TLE file!", catalogNumber);
+        }
+    } else if (satelliteName == "") {
+        index = getParentModule()->getIndex();
+        if (index >= static_cast< long >(catalog->size())) {
+            EV << "Error in Norad::initializeMobility(): Cannot read further satellites from TLE file!" << std::endl;
+            endSimulation();
+        }
     } else {
-        do {
-            line_str = "";
-            tleFile.getline(line, 100);
-            line_str.append(line);
-        } while (tleFile.good()
-                && line_str.find(satelliteName.c_str()) == std::string::npos);
+        index = catalog->find(satelliteName);
+        if (index < 0) {
+            error("Error in Norad::initializeMobility(): Satellite \"%s\" not found in TLE file!", satelliteName.c_str());
+        }
+    }
+    if (validateChecksums && !catalog->isValid(index)) {
+        error("Error in Norad::initializeMobility(): TLE data of satellite %ld has an invalid checksum!", index);
     }
-    tleFile.getline(line1tmp, 100);
-    tleFile.getline(line2tmp, 100);
+
+    std::string line_str = catalog->getName(index);
+    line1 = catalog->getLine1(index);
+    line2 = catalog->getLine2(index);
 
     // Pretty up the satellites name
     line_str = line_str.substr(0, line_str.find("  "));
     line0 = line_str;
-    line1.append(line1tmp);
-    line2.append(line2tmp);
-    cTle tle(line0, line1, line2);
-    orbit = new cOrbit(tle);
+
+    // Use the orbit constructed during the parallel ingest if available
+    orbit = (catalogControl != nullptr) ? catalogControl->takeOrbit(filename, index) : nullptr;
+    if (orbit == nullptr) {
+        cTle tle(line0, line1, line2);
+        orbit = new cOrbit(tle);
+    }
 
     // Gap is needed to eliminate different start times
     gap = orbit->TPlusEpoch(currentJulian);
 
+    // The ephemeris is cached per element set and update interval on a grid relative to the epoch
+    std::string ephemerisCacheDir = par("ephemerisCacheDir").stdstringValue();
+    if (ephemerisCacheDir != "" && updateInterval > 0) {
+        const std::string tleText = line0 + "\n" + line1 + "\n" + line2;
+        ephemerisCache = new EphemerisCache();
+        ephemerisCache->open(ephemerisCacheDir, TLECatalog::hash(tleText.c_str(), tleText.size()),
+                             updateInterval.dbl(), gap);
+    }
+
     updateTime(targetTime);
 
     // Set name from TLE file for icon name
@@ -101,26 +144,137 @@ void Norad::initializeMobility(const simtime_t& targetTime)
     getParentModule()->setName(satName.c_str());
 }
 
+TLECatalogControl* Norad::findCatalogControl()
+{
+    cModule* network = getParentModule()->getParentModule();
+    cModule* cniOs3 = (network != nullptr) ? network->getSubmodule("cni_os3") : nullptr;
+    if (cniOs3 == nullptr) {
+        return nullptr;
+    }
+    return dynamic_cast< TLECatalogControl* >(cniOs3->getSubmodule("tleCatalog"));
+}
+
 void Norad::updateTime(const simtime_t& targetTime)
 {
-    orbit->getPosition((gap + targetTime.dbl()) / 60, &eci);
-    geoCoord = eci.toGeo();
+    // The last state starts the next interpolation interval
+    if (interpolation) {
+        previousEci = eci;
+        previousTime = eciTime;
+        interpolatedTime = -1;
+    }
+    eciTime = targetTime;
+
+    const double tsince = (gap + targetTime.dbl()) / 60;
+    if (ephemerisCache == nullptr) {
+        orbit->getPosition(tsince, &eci);
+        geoCoord = eci.toGeo();
+        return;
+    }
+
+    // Only times on the grid of the update interval are cached
+    std::int64_t index;
+    if (!ephemerisCache->getIndex(gap + targetTime.dbl(), index)) {
+        orbit->getPosition(tsince, &eci);
+        geoCoord = eci.toGeo();
+        return;
+    }
+
+    const double* sample = ephemerisCache->getSample(index);
+    if (sample != nullptr) {
+        // Cache hit: the date is calculated exactly as by the orbit models
+        cJulian date = orbit->Epoch();
+        date.addMin(tsince);
+        eci = cEci(cVector(sample[0], sample[1], sample[2]), cVector(sample[3], sample[4], sample[5]), date, false);
+        eci.setUnitsKm();
+        geoCoord = cCoordGeo(sample[6], sample[7], sample[8]);
+        ephemerisHits++;
+        return;
+    }
+
+    orbit->getPosition(tsince, &eci);
+    geoCoord = eci.toGeo();  // converts eci to km-based units
+    const cVector pos = eci.getPos();
+    const cVector vel = eci.getVel();
+    const double newSample[EphemerisCache::SampleSize] = { pos.m_x, pos.m_y, pos.m_z, vel.m_x, vel.m_y, vel.m_z,
+                                                           geoCoord.m_Lat, geoCoord.m_Lon, geoCoord.m_Alt };
+    ephemerisCache->addSample(index, newSample);
+    ephemerisMisses++;
+}
+
+const cEci& Norad::getCurrentEci()
+{
+    const simtime_t now = simTime();
+    if (!interpolation || previousTime < SIMTIME_ZERO || now < previousTime || now >= eciTime) {
+        return eci;
+    }
+    if (now != interpolatedTime) {
+        interpolate(now);
+    }
+    return interpolatedEci;
+}
+
+const cCoordGeo& Norad::getCurrentGeo()
+{
+    const simtime_t now = simTime();
+    if (!interpolation || previousTime < SIMTIME_ZERO || now < previousTime || now >= eciTime) {
+        return geoCoord;
+    }
+    if (now != interpolatedTime) {
+        interpolate(now);
+    }
+    return interpolatedGeo;
+}
+
+void Norad::interpolate(const simtime_t& time)
+{
+    // Cubic Hermite basis functions and their derivatives on the normalized interval [0, 1];
+    // the ECI frame is inertial, so the orbit is smooth in it and the velocities are the exact slopes
+    const double h = (eciTime - previousTime).dbl();
+    const double s = (time - previousTime).dbl() / h;
+    const double s2 = s * s;
+    const double s3 = s2 * s;
+    const double h00 = 2 * s3 - 3 * s2 + 1;
+    const double h10 = s3 - 2 * s2 + s;
+    const double h01 = -2 * s3 + 3 * s2;
+    const double h11 = s3 - s2;
+    const double d00 = 6 * s2 - 6 * s;
+    const double d10 = 3 * s2 - 4 * s + 1;
+    const double d01 = -d00;
+    const double d11 = 3 * s2 - 2 * s;
+
+    const cVector p0 = previousEci.getPos();
+    const cVector v0 = previousEci.getVel();
+    const cVector p1 = eci.getPos();
+    const cVector v1 = eci.getVel();
+    const cVector pos(h00 * p0.m_x + h10 * h * v0.m_x + h01 * p1.m_x + h11 * h * v1.m_x,
+                      h00 * p0.m_y + h10 * h * v0.m_y + h01 * p1.m_y + h11 * h * v1.m_y,
+                      h00 * p0.m_z + h10 * h * v0.m_z + h01 * p1.m_z + h11 * h * v1.m_z);
+    const cVector vel((d00 * p0.m_x + d01 * p1.m_x) / h + d10 * v0.m_x + d11 * v1.m_x,
+                      (d00 * p0.m_y + d01 * p1.m_y) / h + d10 * v0.m_y + d11 * v1.m_y,
+                      (d00 * p0.m_z + d01 * p1.m_z) / h + d10 * v0.m_z + d11 * v1.m_z);
+
+    cJulian date = previousEci.getDate();
+    date.addSec(s * h);
+    interpolatedEci = cEci(pos, vel, date, false);
+    interpolatedEci.setUnitsKm();
+    interpolatedGeo = interpolatedEci.toGeo();
+    interpolatedTime = time;
 }
 
 double Norad::getLongitude()
 {
-    return rad2deg(geoCoord.m_Lon);
+    return rad2deg(getCurrentGeo().m_Lon);
 }
 
 double Norad::getLatitude()
 {
-    return rad2deg(geoCoord.m_Lat);
+    return rad2deg(getCurrentGeo().m_Lat);
 }
 
 double Norad::getElevation(const double& refLatitude, const double& refLongitude, const double& refAltitude)
 {
     cSite siteEquator(refLatitude, refLongitude, refAltitude);
-    cCoordTopo topoLook = siteEquator.getLookAngle(eci);
+    cCoordTopo topoLook = siteEquator.getLookAngle(getCurrentEci());
     if (topoLook.m_El == 0.0) {
         error("Error in Norad::getElevation(): Corrupted database.");
     }
@@ -130,7 +284,7 @@ double Norad::getElevation(const double& refLatitude, const double& refLongitude
 double Norad::getAzimuth(const double& refLatitude, const double& refLongitude, const double& refAltitude)
 {
     cSite siteEquator(refLatitude, refLongitude, refAltitude);
-    cCoordTopo topoLook = siteEquator.getLookAngle(eci);
+    cCoordTopo topoLook = siteEquator.getLookAngle(getCurrentEci());
     if (topoLook.m_El == 0.0) {
         error("Error in Norad::getAzimuth(): Corrupted database.");
     }
@@ -139,14 +293,23 @@ double Norad::getAzimuth(const double& refLatitude, const double& refLongitude,
 
 double Norad::getAltitude()
 {
-    geoCoord = eci.toGeo();
-    return geoCoord.m_Alt;
+    return getCurrentGeo().m_Alt;
+}
+
+double Norad::getEccentricity() const
+{
+    return orbit->Eccentricity();
+}
+
+double Norad::getPerigee() const
+{
+    return orbit->Perigee();
 }
 
 double Norad::getDistance(const double& refLatitude, const double& refLongitude, const double& refAltitude)
 {
     cSite siteEquator(refLatitude, refLongitude, refAltitude);
-    cCoordTopo topoLook = siteEquator.getLookAngle(eci);
+    cCoordTopo topoLook = siteEquator.getLookAngle(getCurrentEci());
     double distance = topoLook.m_Range;
     return distance;
 }
@@ -27,6 +27,8 @@
 
 class cTle;
 class cOrbit;
+class TLECatalogControl;
+class EphemerisCache;
 
 //-----------------------------------------------------
 // Class: Norad
@@ -48,11 +50,17 @@ public:
     // targetTime: End time of current linear movement
     void updateTime(const simtime_t& targetTime);
 
+    // Enables the interpolation between the last two updates: queries before the end time of the
+    // current movement are answered by cubic Hermite interpolation of the ECI position and velocity
+    // instead of the state at the end time
+    void setInterpolation(bool enabled)    { interpolation = enabled; }
+
     // This method gets the current simulation time, cares for the file download (happens only once)
     // of the TLE files from the web and reads the values for the satellites according to the
     // omnet.ini-file. The information is provided by the respective mobility class.
     // targetTime: End time of current linear movement
-    virtual void initializeMobility(const simtime_t& targetTime);
+    // updateInterval: Time between two position updates (time grid of the ephemeris cache)
+    virtual void initializeMobility(const simtime_t& targetTime, const simtime_t& updateInterval);
 
     // returns the longitude
     double getLongitude();
@@ -69,6 +77,10 @@ public:
     // returns the altitude
     double getAltitude();
 
+    // returns the eccentricity and the perigee altitude (in km) of the orbit
+    double getEccentricity() const;
+    double getPerigee() const;
+
     void finish();
 
     // returns the distance to the satellite from a reference point (distance in km)
@@ -77,6 +89,16 @@ public:
 protected:
     virtual void handleMessage(cMessage* msg);
 
+    // returns the shared TLE catalog module of the network, nullptr if there is none
+    TLECatalogControl* findCatalogControl();
+
+    // returns the state at the current simulation time (interpolated if enabled, see setInterpolation())
+    const cEci& getCurrentEci();
+    const cCoordGeo& getCurrentGeo();
+
+    // interpolates the state between the last two updates at time
+    void interpolate(const simtime_t& time);
+
 private:
     cEci eci;
     cJulian currentJulian;
@@ -84,7 +106,19 @@ private:
 
     cTle* tle;
     cOrbit* orbit;
+    EphemerisCache* ephemerisCache;
+    unsigned long ephemerisHits;
+    unsigned long ephemerisMisses;
     cCoordGeo geoCoord;
+
+    // Interpolation between the last two updates
+    bool interpolation;
+    simtime_t eciTime;             // time of eci
+    cEci previousEci;
+    simtime_t previousTime;        // time of previousEci, negative if there is none
+    cEci interpolatedEci;
+    cCoordGeo interpolatedGeo;
+    simtime_t interpolatedTime;    // time of interpolatedEci, negative if there is none
     std::string line0;
     std::string line1;
     std::string line2;
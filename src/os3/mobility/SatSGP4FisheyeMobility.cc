@@ -17,7 +17,7 @@
 
 #include <cmath>
 
-#include "os3/mobility/Norad.h"
+#include "os3/libnorad/globals.h"
 
 Define_Module(SatSGP4FisheyeMobility);
 
@@ -37,12 +37,13 @@ void SatSGP4FisheyeMobility::initialize(int stage)
 
 void SatSGP4FisheyeMobility::setTargetPosition()
 {
-    nextChange += updateInterval.dbl();
-    noradModule->updateTime(nextChange);
+    nextChange += getNextUpdateInterval().dbl();
+    updateSatellite(nextChange);
+    numUpdates++;
 
     double radius = mapX / 2 - 1;
-    const double elevation = noradModule->getElevation(refCenterLatitude, refCenterLongitude, refCenterAltitude);
-    const double azimuth = noradModule->getAzimuth(refCenterLatitude, refCenterLongitude, refCenterAltitude);
+    const double elevation = getElevation(refCenterLatitude, refCenterLongitude, refCenterAltitude);
+    const double azimuth = getAzimuth(refCenterLatitude, refCenterLongitude, refCenterAltitude);
 
     if (elevation > 0) {
         radius -= std::abs((elevation / 90.0) * mapX / 2);
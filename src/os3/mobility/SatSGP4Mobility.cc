@@ -15,29 +15,92 @@
 
 #include "os3/mobility/SatSGP4Mobility.h"
 
+#include <algorithm>
 #include <ctime>
 #include <cmath>
+#include <vector>
 
+#include "os3/base/Calculation.h"
+#include "os3/base/ConstellationManager.h"
+#include "os3/base/LinkBudget.h"
+#include "os3/libnorad/globals.h"
 #include "os3/mobility/Norad.h"
 
 Define_Module(SatSGP4Mobility);
 
+namespace {
+
+// Lower limit of the perigee altitude (km) in the speed bound of the adaptive update interval, e.g., for decaying orbits
+const double MinPerigeeAltitude = 100;
+
+}
+
 SatSGP4Mobility::SatSGP4Mobility()
 {
    noradModule = nullptr;
+   constellation = nullptr;
+   constellationIndex = -1;
+   calculation = nullptr;
    mapX = 0;
    mapY = 0;
    transmitPower = 0.0;
+   adaptiveUpdateInterval = false;
+   numUpdates = 0;
 }
 
 void SatSGP4Mobility::initialize(int stage)
 {
     // noradModule must be initialized before LineSegmentsMobilityBase calling setTargetPosition() in its initialization at stage 1
     if (stage == 1) {
-        noradModule->initializeMobility(nextChange);
+        const bool interpolatePosition = par("interpolatePosition").boolValue();
+        if (par("constellationView").boolValue()) {
+            if (interpolatePosition) {
+                error("Error in SatSGP4Mobility::initialize(): interpolatePosition is not supported for constellation views.");
+            }
+            if (adaptiveUpdateInterval) {
+                error("Error in SatSGP4Mobility::initialize(): adaptiveUpdateInterval is not supported for constellation views.");
+            }
+            // The constellation is initialized in stage 0, the satellite is selected like by the Norad module
+            constellation = findConstellation();
+            if (constellation == nullptr || !constellation->isEnabled()) {
+                error("Error in SatSGP4Mobility::initialize(): constellationView requires a ConstellationManager with a TLE file.");
+            }
+            cModule* satellite = getParentModule();
+            const long catalogNumber = satellite->hasPar("catalogNumber") ? satellite->par("catalogNumber").longValue() : -1;
+            constellationIndex = constellation->findSatellite(catalogNumber, satellite->par("satelliteName").stdstringValue(),
+                                                              satellite->getIndex());
+            if (constellationIndex < 0) {
+                error("Error in SatSGP4Mobility::initialize(): Satellite is not part of the constellation.");
+            }
+            constellation->attachView();
+            constellation->update(nextChange);
+        } else {
+            noradModule->setInterpolation(interpolatePosition);
+            noradModule->initializeMobility(nextChange, regularUpdateInterval);
+        }
     }
     LineSegmentsMobilityBase::initialize(stage);
 
+    if (stage == 0) {
+        regularUpdateInterval = updateInterval;
+        adaptiveUpdateInterval = par("adaptiveUpdateInterval").boolValue();
+        if (adaptiveUpdateInterval) {
+            minUpdateInterval = par("minUpdateInterval");
+            maxUpdateInterval = par("maxUpdateInterval");
+            if (minUpdateInterval <= 0 || minUpdateInterval > regularUpdateInterval || maxUpdateInterval < regularUpdateInterval) {
+                error("Error in SatSGP4Mobility::initialize(): It has to hold 0 < minUpdateInterval <= updateInterval <= maxUpdateInterval.");
+            }
+            cModule* network = getParentModule()->getParentModule();
+            cModule* cniOs3 = (network != nullptr) ? network->getSubmodule("cni_os3") : nullptr;
+            calculation = (cniOs3 != nullptr) ? dynamic_cast< Calculation* >(cniOs3->getSubmodule("calculation")) : nullptr;
+            if (calculation == nullptr) {
+                error("Error in SatSGP4Mobility::initialize(): adaptiveUpdateInterval requires the Calculation module.");
+            }
+            // Without a periodic update interval, the base class only schedules updates at nextChange
+            updateInterval = 0;
+        }
+    }
+
     noradModule = check_and_cast< Norad* >(getParentModule()->getSubmodule("NoradModule"));
     if (noradModule == nullptr) {
         error("Error in SatSGP4Mobility::initializeMobility(): Cannot find module Norad.");
@@ -62,50 +125,138 @@ void SatSGP4Mobility::initialize(int stage)
 
 double SatSGP4Mobility::getAltitude() const
 {
+    if (constellation != nullptr) {
+        return constellation->getAltitude(constellationIndex);
+    }
     return noradModule->getAltitude();
 }
 
 double SatSGP4Mobility::getElevation(const double& refLatitude, const double& refLongitude,
                                      const double& refAltitude) const
 {
+    if (constellation != nullptr) {
+        return constellation->getElevation(constellationIndex, refLatitude, refLongitude, refAltitude);
+    }
     return noradModule->getElevation(refLatitude, refLongitude, refAltitude);
 }
 
 double SatSGP4Mobility::getAzimuth(const double& refLatitude, const double& refLongitude,
                                    const double& refAltitude) const
 {
+    if (constellation != nullptr) {
+        return constellation->getAzimuth(constellationIndex, refLatitude, refLongitude, refAltitude);
+    }
     return noradModule->getAzimuth(refLatitude, refLongitude, refAltitude);
 }
 
 double SatSGP4Mobility::getDistance(const double& refLatitude, const double& refLongitude,
                                     const double& refAltitude) const
 {
+    if (constellation != nullptr) {
+        return constellation->getDistance(constellationIndex, refLatitude, refLongitude, refAltitude);
+    }
     return noradModule->getDistance(refLatitude, refLongitude, refAltitude);
 }
 
 double SatSGP4Mobility::getLongitude() const
 {
+    if (constellation != nullptr) {
+        return constellation->getLongitude(constellationIndex);
+    }
     return noradModule->getLongitude();
 }
 
 double SatSGP4Mobility::getLatitude() const
 {
+    if (constellation != nullptr) {
+        return constellation->getLatitude(constellationIndex);
+    }
     return noradModule->getLatitude();
 }
 
+void SatSGP4Mobility::updateSatellite(const simtime_t& time)
+{
+    // All views request the same times, so the constellation is propagated once per update interval
+    if (constellation != nullptr) {
+        constellation->update(time);
+    } else {
+        noradModule->updateTime(time);
+    }
+}
+
+ConstellationManager* SatSGP4Mobility::findConstellation()
+{
+    cModule* network = getParentModule()->getParentModule();
+    cModule* cniOs3 = (network != nullptr) ? network->getSubmodule("cni_os3") : nullptr;
+    if (cniOs3 == nullptr) {
+        return nullptr;
+    }
+    return dynamic_cast< ConstellationManager* >(cniOs3->getSubmodule("constellation"));
+}
+
+simtime_t SatSGP4Mobility::getNextUpdateInterval()
+{
+    return adaptiveUpdateInterval ? calcAdaptiveUpdateInterval() : regularUpdateInterval;
+}
+
+simtime_t SatSGP4Mobility::calcAdaptiveUpdateInterval()
+{
+    const unitVectors& stations = calculation->getGroundStations();
+    if (stations.size() == 0) {
+        return maxUpdateInterval;
+    }
+
+    // Distance of the sub-satellite point to the nearest horizon circle (in km); the satellite is in view of a
+    // ground station if the station is inside the horizon circle of the satellite
+    const double altitude = getAltitude();
+    const double horizonDistance = LinkBudget::EarthRadius * LinkBudget::calcHorizonAngle(altitude);
+    std::vector< double > distances;
+    LinkBudget::calcDistances(getLatitude(), getLongitude(), stations, distances);
+    double margin = std::abs(distances[0] - horizonDistance);
+    bool inView = false;
+    for (std::size_t i = 0; i < distances.size(); i++) {
+        margin = std::min(margin, std::abs(distances[i] - horizonDistance));
+        inView = inView || distances[i] < horizonDistance;
+    }
+
+    // Upper bound of the speed at which the margin shrinks (Keplerian orbit): the angular speed of the sub-satellite
+    // point is at most the one at perigee (vis-viva), plus the rotation of the earth, and the horizon circle shrinks
+    // at most by the maximum radial speed of the orbit at the perigee radius. Both bounds hold over the whole orbit,
+    // so they also hold for eccentric orbits between now and the next update.
+    const double eccentricity = noradModule->getEccentricity();
+    const double perigeeRadius = LinkBudget::EarthRadius
+            + std::max(std::min(noradModule->getPerigee(), altitude), MinPerigeeAltitude);
+    const double perigeeSpeed = std::sqrt(GM * (1 + eccentricity) / perigeeRadius);
+    const double groundSpeed = perigeeSpeed * LinkBudget::EarthRadius / perigeeRadius
+            + TWOPI * LinkBudget::EarthRadius / DAY_SIDERAL;
+    const double radialSpeed = GM * eccentricity / (perigeeRadius * perigeeSpeed);
+    const double horizonSpeed = radialSpeed * LinkBudget::EarthRadius * LinkBudget::EarthRadius
+            / (perigeeRadius * std::sqrt(perigeeRadius * perigeeRadius - LinkBudget::EarthRadius * LinkBudget::EarthRadius));
+
+    simtime_t interval = margin / (groundSpeed + horizonSpeed);
+    interval = std::min(interval, inView ? regularUpdateInterval : maxUpdateInterval);
+    return std::max(interval, minUpdateInterval);
+}
+
 void SatSGP4Mobility::setTargetPosition()
 {
-    nextChange += updateInterval.dbl();
-    noradModule->updateTime(nextChange);
+    nextChange += getNextUpdateInterval().dbl();
+    updateSatellite(nextChange);
+    numUpdates++;
 
-    lastPosition.x = mapX * noradModule->getLongitude() / 360 + (mapX / 2);
+    lastPosition.x = mapX * getLongitude() / 360 + (mapX / 2);
     lastPosition.x = static_cast<int>(lastPosition.x) % static_cast<int>(mapX);
-    lastPosition.y = ((-mapY * noradModule->getLatitude()) / 180) + (mapY / 2);
+    lastPosition.y = ((-mapY * getLatitude()) / 180) + (mapY / 2);
 
     targetPosition.x = lastPosition.x;
     targetPosition.y = lastPosition.y;
 }
 
+void SatSGP4Mobility::finish()
+{
+    recordScalar("positionUpdates", numUpdates);
+}
+
 void SatSGP4Mobility::move()
 {
     LineSegmentsMobilityBase::move();
@@ -18,6 +18,8 @@
 
 #include "mobility/common/LineSegmentsMobilityBase.h"    // inet
 
+class Calculation;
+class ConstellationManager;
 class Norad;
 
 //-----------------------------------------------------
@@ -26,6 +28,12 @@ class Norad;
 // Realizes the SatSGP4 mobility module - provides methods to get and set
 // the position of a satellite module and resets the satellite position when
 // it gets outside the playground.
+// The satellite is either propagated by the Norad module of the satellite or, as a
+// view, taken from the ConstellationManager of the network (parameter constellationView).
+// With interpolatePosition, the Norad module answers queries between two updates by
+// interpolating the orbit; the position on the playground still changes at the updates.
+// With adaptiveUpdateInterval, the time until the next update depends on how far the
+// satellite is from the horizon of the nearest ground station.
 //-----------------------------------------------------
 class SatSGP4Mobility : public LineSegmentsMobilityBase
 {
@@ -58,19 +66,45 @@ public:
 
 protected:
     Norad* noradModule;
+    ConstellationManager* constellation;     // nullptr if the satellite is propagated by noradModule
+    long constellationIndex;                 // index of the satellite in the constellation
+    Calculation* calculation;                // provides the ground stations for the adaptive update interval
     int mapX, mapY;
     double transmitPower;
 
+    // Adaptive update interval; the base class then only schedules updates at nextChange
+    bool adaptiveUpdateInterval;
+    simtime_t regularUpdateInterval;         // configured updateInterval, the longest interval while in view
+    simtime_t minUpdateInterval;
+    simtime_t maxUpdateInterval;
+    unsigned long numUpdates;
+
     // initialize module
     // - creates a reference to the Norad moudule
     // - timestamps and initial position on playground are managed here.
     virtual void initialize(int stage);
 
+    virtual void finish();
+
     // sets the position of satellite
     // - sets the target position for the satellite
     // - the position is fetched from the Norad module with reference to the current timestamp
     virtual void setTargetPosition();
 
+    // propagates the satellite to time (by the Norad module or the constellation)
+    void updateSatellite(const simtime_t& time);
+
+    // returns the ConstellationManager module of the network, nullptr if there is none
+    ConstellationManager* findConstellation();
+
+    // returns the time until the next update (updateInterval or the adaptive update interval)
+    simtime_t getNextUpdateInterval();
+
+    // returns the time the sub-satellite point needs at least to reach the horizon circle of the nearest
+    // ground station, bounded by minUpdateInterval and maxUpdateInterval (or regularUpdateInterval while
+    // a ground station is in view)
+    simtime_t calcAdaptiveUpdateInterval();
+
     // resets the position of the satellite
     // - wraps around the position of the satellite if it reaches the end of the playground
     virtual void fixIfHostGetsOutside();